@@ -0,0 +1,387 @@
+#ifndef ALSAPP_ASYNC_MICROPHONE_HPP
+#define ALSAPP_ASYNC_MICROPHONE_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/alsa_interface.h"    // snd_pcm_*, SND_PCM_*
+#include "alsapp/detail/async_generator.hpp" // alsapp::detail::AsyncGenerator
+#include "alsapp/detail/check_action.hpp"    // alsapp::detail::check_action
+#include "alsapp/detail/device.hpp"          // alsapp::detail::Device
+#include "alsapp/detail/device_settings.hpp" // alsapp::detail::DeviceSettings
+#include "alsapp/detail/pcm_format.hpp"      // alsapp::detail::PcmFormat
+#include "alsapp/reactor.hpp"                // alsapp::Reactor, ReactorWaiter
+#include <cerrno>                            // EAGAIN, EPIPE, ESTRPIPE
+#include <coroutine>                         // std::coroutine_handle
+#include <cstddef>                           // std::size_t
+#include <cstdint>                           // std::uint64_t
+#include <memory>                            // std::unique_ptr
+#include <poll.h>                            // pollfd, POLLIN
+#include <sys/timerfd.h>                     // timerfd_*
+#include <unistd.h>                          // close, read
+#include <vector>                            // std::vector
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// A non-blocking Microphone driven by a Reactor: 'co_await next_periods()'
+// suspends until at least one whole period is ready, then reads every ready
+// period (up to the buffer's capacity) at once.  Many microphones and their
+// consumers can share one thread; nothing blocks and no thread is parked
+// per device.  A suspended stream is resumed on a timer rather than in a
+// blocking wait.
+class AsyncMicrophone : private detail::Device,
+                        private detail::PcmFormat,
+                        private detail::ReactorWaiter
+{
+private:
+    // request a capture stream
+    static const snd_pcm_stream_t stream_mode = SND_PCM_STREAM_CAPTURE;
+
+    // Resume Settings
+    // -------------------------------------------------------------------------
+    // retry interval while the system resumes a suspended stream, and the
+    // attempts made before restarting it instead (5 seconds)
+    static const long resume_interval_msec = 100;
+    static const unsigned int max_resume_attempts = 50;
+
+
+public:
+    using detail::PcmFormat::period_type; // audio units
+
+    // periods delivered by periods()
+    struct Chunk
+    {
+        const char *data;
+        std::size_t size; // bytes, whole periods
+    }; // struct Chunk
+
+    class NextPeriods
+    {
+    public:
+        bool
+        await_ready()
+        {
+            return microphone.try_read(buffer, capacity);
+        }
+
+        void
+        await_suspend(const std::coroutine_handle<> awaiting)
+        {
+            microphone.suspend(awaiting, buffer, capacity);
+        }
+
+        // bytes read
+        std::size_t
+        await_resume() const
+        {
+            return microphone.result();
+        }
+
+
+    private:
+        friend class AsyncMicrophone;
+
+        NextPeriods(AsyncMicrophone &microphone,
+                    period_type *const buffer,
+                    const std::size_t capacity)
+            : microphone(microphone),
+              buffer(buffer),
+              capacity(capacity)
+        {}
+
+        AsyncMicrophone &microphone;
+        period_type *const buffer;
+        const std::size_t capacity;
+    }; // class NextPeriods
+
+    AsyncMicrophone(Reactor &reactor,
+                    const char *const device_name = "default")
+        : detail::Device(device_name,
+                         stream_mode,
+                         SND_PCM_NONBLOCK), // open device
+          reactor(reactor),
+          timer_descriptor(-1),
+          resume_attempts(0),
+          frames_read(0),
+          overruns(0)
+    {
+        detail::DeviceSettings settings(*this);
+
+        // apply settings
+        detail::PcmFormat::apply(settings);
+        settings.finalize();
+
+        const int count = snd_pcm_poll_descriptors_count(*this);
+        detail::check_action("count poll descriptors", count);
+
+        descriptors.resize(static_cast<std::size_t>(count));
+        detail::check_action("get poll descriptors",
+                             snd_pcm_poll_descriptors(*this,
+                                                      descriptors.data(),
+                                                      descriptors.size()));
+
+        timer_descriptor = timerfd_create(CLOCK_MONOTONIC,
+                                          TFD_NONBLOCK | TFD_CLOEXEC);
+        detail::check_action("create resume timer",
+                             (timer_descriptor < 0) ? -errno : 0);
+
+        timer_source = { this, timer_descriptor };
+        reactor.add(timer_source);
+
+        sources.reset(new detail::ReactorSource[descriptors.size()]);
+        for (std::size_t i = 0; i < descriptors.size(); ++i) {
+            sources[i] = { this, descriptors[i].fd };
+            reactor.add(sources[i]);
+        }
+    }
+
+    ~AsyncMicrophone()
+    {
+        for (std::size_t i = 0; i < descriptors.size(); ++i)
+            reactor.remove(sources[i]);
+
+        reactor.remove(timer_source);
+        (void) ::close(timer_descriptor);
+    }
+
+    AsyncMicrophone(const AsyncMicrophone &)            = delete;
+    AsyncMicrophone &operator=(const AsyncMicrophone &) = delete;
+
+    // await the next whole periods, results in bytes read
+    NextPeriods
+    next_periods(period_type *const buffer,
+                 const std::size_t capacity)
+    {
+        return NextPeriods(*this, buffer, capacity);
+    }
+
+    template<std::size_t capacity>
+    NextPeriods
+    next_periods(period_type (&buffer)[capacity])
+    {
+        return next_periods(&buffer[0], capacity);
+    }
+
+    // overruns and suspends recovered from (each loses captured frames)
+    std::size_t
+    overrun_count() const
+    {
+        return overruns;
+    }
+
+    // endless stream of captured chunks of up to 'capacity' periods, each
+    // valid until the next is awaited
+    detail::AsyncGenerator<Chunk>
+    periods(const std::size_t capacity)
+    {
+        const std::unique_ptr<period_type[]> buffer(new period_type[capacity]);
+
+        for (;;) {
+            const std::size_t size = co_await next_periods(buffer.get(),
+                                                           capacity);
+
+            co_yield Chunk{ &buffer[0][0], size };
+        }
+    }
+
+
+private:
+    // read every ready whole period without blocking, false if none are
+    bool
+    try_read(period_type *const buffer,
+             const std::size_t capacity)
+    {
+        if (resume_attempts > 0)
+            return false; // the resume timer is armed instead
+        // poll() never wakes on a capture stream that isn't running
+        if (snd_pcm_state(*this) == SND_PCM_STATE_PREPARED)
+            detail::check_action("start microphone",
+                                 snd_pcm_start(*this));
+
+        const snd_pcm_sframes_t available = snd_pcm_avail_update(*this);
+        if (available < 0)
+            return recover(available);
+
+        std::size_t period_count = static_cast<std::size_t>(available)
+                                 / period_frame_size;
+        if (period_count == 0)
+            return false;
+
+        period_count = (period_count < capacity) ? period_count : capacity;
+
+        frames_read = snd_pcm_readi(*this,
+                                    buffer,
+                                    period_count * period_frame_size);
+
+        return (frames_read < 0) ? recover(frames_read) : true;
+    }
+
+    // restart after an overrun or suspend and keep waiting, anything else
+    // is reported by await_resume
+    bool
+    recover(const snd_pcm_sframes_t status)
+    {
+        if (status == -EAGAIN)
+            return false;
+
+        if (status == -EPIPE) {
+            ++overruns;
+            return restart();
+        }
+
+        if (status == -ESTRPIPE) {
+            ++overruns;
+            return resume();
+        }
+
+        frames_read = status; // for await_resume
+        return true;
+    }
+
+    // Try resuming a suspended stream in place.  While the system is still
+    // resuming, the retry is left to the timer (the reactor keeps running
+    // meanwhile); once the driver can't resume, or takes too long, the
+    // stream is restarted instead.
+    bool
+    resume()
+    {
+        const int resumed = snd_pcm_resume(*this);
+
+        if ((resumed == -EAGAIN) && (++resume_attempts < max_resume_attempts))
+            return false;
+
+        resume_attempts = 0;
+
+        return (resumed == 0) ? false : restart();
+    }
+
+    // prepare and start the stream again, false to keep waiting
+    bool
+    restart()
+    {
+        int status = snd_pcm_prepare(*this);
+        if (status == 0)
+            status = snd_pcm_start(*this);
+        if (status == 0)
+            return false;
+
+        frames_read = status; // for await_resume
+        return true;
+    }
+
+    void
+    suspend(const std::coroutine_handle<> awaiting,
+            period_type *const buffer,
+            const std::size_t capacity)
+    {
+        this->awaiting = awaiting;
+        this->buffer   = buffer;
+        this->capacity = capacity;
+
+        wait();
+    }
+
+    // arm the device's descriptors, or the timer while resuming
+    void
+    wait()
+    {
+        if (resume_attempts > 0) {
+            itimerspec interval = {};
+            interval.it_value.tv_sec  = resume_interval_msec / 1000;
+            interval.it_value.tv_nsec = (resume_interval_msec % 1000) * 1000000;
+
+            detail::check_action("arm resume timer",
+                                 (timerfd_settime(timer_descriptor,
+                                                  0,
+                                                  &interval,
+                                                  nullptr) < 0) ? -errno : 0);
+            reactor.arm(timer_source, POLLIN);
+            return;
+        }
+
+        for (std::size_t i = 0; i < descriptors.size(); ++i)
+            reactor.arm(sources[i], descriptors[i].events);
+    }
+
+    std::size_t
+    result() const
+    {
+        detail::check_action("read from microphone",
+                             static_cast<int>(frames_read));
+
+        return static_cast<std::size_t>(frames_read) * sizeof(frame_type);
+    }
+
+    std::coroutine_handle<>
+    ready(const int descriptor,
+          const short events) override
+    {
+        if (!awaiting)
+            return nullptr;
+
+        if (descriptor == timer_descriptor) {
+            std::uint64_t expirations;
+            (void) ::read(timer_descriptor, &expirations, sizeof(expirations));
+
+            return retry_resume();
+        }
+
+        // let the plugin translate its descriptors' events
+        for (pollfd &entry : descriptors)
+            entry.revents = (entry.fd == descriptor) ? events : 0;
+
+        unsigned short revents;
+        detail::check_action("demangle poll events",
+                             snd_pcm_poll_descriptors_revents(
+                                 *this,
+                                 descriptors.data(),
+                                 descriptors.size(),
+                                 &revents
+                             ));
+
+        if ((revents != 0) && try_read(buffer, capacity)) {
+            const std::coroutine_handle<> resumed = awaiting;
+            awaiting = nullptr;
+            return resumed;
+        }
+
+        // spurious or not a whole period yet
+        wait();
+
+        return nullptr;
+    }
+
+    // the resume timer expired
+    std::coroutine_handle<>
+    retry_resume()
+    {
+        if (resume()) {
+            const std::coroutine_handle<> resumed = awaiting;
+            awaiting = nullptr;
+            return resumed;
+        }
+
+        wait();
+
+        return nullptr;
+    }
+
+    Reactor &reactor;
+    std::vector<pollfd> descriptors;
+    std::unique_ptr<detail::ReactorSource[]> sources; // stable addresses
+    int timer_descriptor;                // timerfd, retries a resume
+    detail::ReactorSource timer_source;
+    unsigned int resume_attempts;        // 0 unless resuming
+
+    std::coroutine_handle<> awaiting; // suspended in next_periods()
+    period_type *buffer;
+    std::size_t capacity;
+    snd_pcm_sframes_t frames_read; // or error status
+    std::size_t overruns;
+}; // class AsyncMicrophone
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_ASYNC_MICROPHONE_HPP
@@ -0,0 +1,374 @@
+#ifndef ALSAPP_BEAMFORMER_HPP
+#define ALSAPP_BEAMFORMER_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/capture_config.hpp"       // alsapp::detail::is_power_of_two
+#include "alsapp/detail/fft.hpp"           // alsapp::detail::Fft
+#include "alsapp/detail/pcm_format.hpp"    // alsapp::detail::PcmFormat
+#include "alsapp/detail/sample_traits.hpp" // alsapp::detail::SampleTraits
+#include <cmath>                           // std::cos, std::sin, std::sqrt
+#include <cstddef>                         // std::size_t
+#include <cstring>                         // std::memcpy, std::memset
+#include <stdexcept>                       // std::invalid_argument
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// microphone position relative to the array center, in meters
+struct MicrophonePosition
+{
+    float x;
+    float y;
+    float z;
+}; // struct MicrophonePosition
+
+// Delay-and-sum beamformer over 'channel_count' planar channels of 'Sample'
+// (see MultichannelMicrophone::planar_period_type), producing one mono
+// Microphone-format period per input period.
+//
+// Each channel is delayed by a windowed-sinc fractional delay filter and the
+// channels are averaged.  Delays come from the array geometry and a steering
+// direction, or are estimated with GCC-PHAT against channel 0.  When tracking,
+// one channel pair is re-estimated per period, so the per-period cost is
+// bounded at channel_count filters plus three 256-point FFTs.  Estimates are
+// only taken when the correlation peak stands out (not in silence or diffuse
+// noise), and tracked arrivals are smoothed across periods.
+//
+// Output lags input by tap_count / 2 - 1 frames plus the steering delay.
+template<typename Sample,
+         std::size_t channel_count>
+class Beamformer
+{
+    static_assert(channel_count >= 2,
+                  "beamforming needs at least two channels");
+
+public:
+    // Beamformer Settings
+    // -------------------------------------------------------------------------
+    // fractional delay filter length
+    static const std::size_t tap_count = 16;
+
+    // largest steering delay in frames (~68 cm of aperture at 16 kHz)
+    static const std::size_t max_delay_size = 32;
+
+    // speed of sound, m/s
+    static constexpr float speed_of_sound = 343.0f;
+
+    // lowest GCC-PHAT peak (1 for a single clean path) taken as an estimate,
+    // uncorrelated noise peaks around 0.15 over the steerable lags
+    static constexpr float min_peak_confidence = 0.3f;
+
+    // weight of the previous arrival when tracking (~10 estimates per pair)
+    static constexpr float arrival_smoothing = 0.9f;
+
+private:
+    typedef detail::PcmFormat::sample_type sample_type;
+
+    static const unsigned int sample_rate = detail::PcmFormat::sample_rate;
+
+    static const std::size_t block_size = detail::PcmFormat::period_frame_size;
+
+    // each channel line holds one period of history then the current period
+    static const std::size_t line_size = 2 * block_size;
+    static const std::size_t fft_size  = line_size;
+
+    static_assert(detail::is_power_of_two(block_size),
+                  "beamforming needs a power of two period frame size");
+    static_assert(max_delay_size + tap_count <= block_size,
+                  "history must cover the longest delay filter");
+
+    typedef float line_type[line_size];
+
+
+public:
+    typedef detail::PcmFormat::period_type period_type; // audio units
+
+    typedef Sample planar_period_type[channel_count][block_size];
+
+    Beamformer()
+        : tracking(false),
+          next_pair(1)
+    {
+        std::memset(lines, 0, sizeof(lines));
+
+        float delays[channel_count] = {};
+        steer_delays(delays);
+    }
+
+    // align channels by explicit delays in (fractional) frames
+    void
+    steer_delays(const float (&delays)[channel_count])
+    {
+        for (std::size_t channel = 0; channel < channel_count; ++channel) {
+            const float delay = delays[channel];
+
+            if (!(delay >= 0.0f) || (delay > max_delay_size))
+                throw std::invalid_argument("steering delay out of range");
+
+            this->delays[channel] = delay;
+            design_filter(channel, delay);
+        }
+    }
+
+    // steer toward a far-field source at 'azimuth' (radians, in the x-y plane
+    // from +x) and 'elevation' (radians above it)
+    void
+    steer(const MicrophonePosition (&geometry)[channel_count],
+          const float azimuth,
+          const float elevation = 0.0f)
+    {
+        const float ux = std::cos(elevation) * std::cos(azimuth);
+        const float uy = std::cos(elevation) * std::sin(azimuth);
+        const float uz = std::sin(elevation);
+
+        // microphones nearer the source hear it first and wait the longest
+        float lead[channel_count];
+        float earliest = 0.0f;
+
+        for (std::size_t channel = 0; channel < channel_count; ++channel) {
+            lead[channel] = ((geometry[channel].x * ux)
+                           + (geometry[channel].y * uy)
+                           + (geometry[channel].z * uz))
+                          * (sample_rate / speed_of_sound);
+
+            if ((channel == 0) || (lead[channel] < earliest))
+                earliest = lead[channel];
+        }
+
+        float delays[channel_count];
+        for (std::size_t channel = 0; channel < channel_count; ++channel)
+            delays[channel] = lead[channel] - earliest;
+
+        steer_delays(delays);
+    }
+
+    // re-estimate one channel's delay against channel 0 every period
+    void
+    track(const bool enabled)
+    {
+        tracking = enabled;
+    }
+
+    // estimate all delays from the current history with GCC-PHAT, channels
+    // without a confident peak keep their delay
+    void
+    estimate_delays()
+    {
+        float estimate;
+
+        for (std::size_t channel = 1; channel < channel_count; ++channel)
+            if (estimate_arrival(channel, estimate))
+                arrival[channel] = estimate;
+
+        apply_arrivals();
+    }
+
+    // current steering delays in frames
+    const float (&steering_delays() const)[channel_count]
+    {
+        return delays;
+    }
+
+    void
+    process(const planar_period_type &channels,
+            period_type &output)
+    {
+        const float scale = 1.0f / detail::SampleTraits<Sample>::full_scale;
+
+        for (std::size_t channel = 0; channel < channel_count; ++channel) {
+            float *const line = lines[channel];
+
+            std::memcpy(&line[0],
+                        &line[block_size],
+                        sizeof(float) * block_size);
+            for (std::size_t i = 0; i < block_size; ++i)
+                line[block_size + i] = static_cast<float>(channels[channel][i])
+                                     * scale;
+        }
+
+        float sum[block_size] = {};
+
+        for (std::size_t channel = 0; channel < channel_count; ++channel)
+            filter_accumulate(channel, sum);
+
+        sample_type samples[block_size];
+        for (std::size_t i = 0; i < block_size; ++i) {
+            float value = sum[i] * (32768.0f / channel_count);
+            value = (value >  32767.0f) ?  32767.0f : value;
+            value = (value < -32768.0f) ? -32768.0f : value;
+            samples[i] = static_cast<sample_type>(value);
+        }
+
+        std::memcpy(output, samples, sizeof(period_type));
+
+        if (tracking) {
+            float estimate;
+
+            if (estimate_arrival(next_pair, estimate)) {
+                arrival[next_pair] = (arrival_smoothing * arrival[next_pair])
+                                   + ((1.0f - arrival_smoothing) * estimate);
+                apply_arrivals();
+            }
+
+            next_pair = (next_pair + 1 < channel_count) ? (next_pair + 1) : 1;
+        }
+    }
+
+
+private:
+    // windowed sinc for delay 'integer + fraction', normalized to unity gain
+    void
+    design_filter(const std::size_t channel,
+                  const float delay)
+    {
+        const float pi = 3.14159265358979323846f;
+
+        const std::size_t integer = static_cast<std::size_t>(delay);
+        const float fraction = delay - static_cast<float>(integer);
+        const float center   = static_cast<float>(tap_count / 2 - 1) + fraction;
+
+        float *const taps = this->taps[channel];
+        float total = 0.0f;
+
+        for (std::size_t k = 0; k < tap_count; ++k) {
+            const float t = static_cast<float>(k) - center;
+            const float sinc = (t == 0.0f) ? 1.0f
+                                           : (std::sin(pi * t) / (pi * t));
+
+            // Blackman window centered on the fractional position
+            const float x = (t + (tap_count / 2.0f)) / tap_count;
+            const float window = 0.42f
+                               - (0.5f  * std::cos(2.0f * pi * x))
+                               + (0.08f * std::cos(4.0f * pi * x));
+
+            taps[k] = sinc * window;
+            total  += taps[k];
+        }
+
+        for (std::size_t k = 0; k < tap_count; ++k)
+            taps[k] /= total;
+
+        offsets[channel] = block_size - integer;
+    }
+
+    // sum += channel delayed through its filter
+    void
+    filter_accumulate(const std::size_t channel,
+                      float *const sum) const
+    {
+        const float *const taps = this->taps[channel];
+        const float *const line = &lines[channel][offsets[channel]];
+
+        // tap-outer loop keeps the frame loop unit stride for vectorization
+        for (std::size_t k = 0; k < tap_count; ++k) {
+            const float tap = taps[k];
+            const float *const input = line - k;
+
+            for (std::size_t i = 0; i < block_size; ++i)
+                sum[i] += tap * input[i];
+        }
+    }
+
+    // GCC-PHAT: frames by which 'channel' hears the source after channel 0,
+    // false if the correlation peak is too weak to tell
+    bool
+    estimate_arrival(const std::size_t channel,
+                     float &estimate)
+    {
+        std::memcpy(reference_re, lines[0],       sizeof(line_type));
+        std::memcpy(cross_re,     lines[channel], sizeof(line_type));
+        std::memset(reference_im, 0, sizeof(line_type));
+        std::memset(cross_im,     0, sizeof(line_type));
+
+        fft.forward(reference_re, reference_im);
+        fft.forward(cross_re,     cross_im);
+
+        // phase transform of X_channel * conj(X_0)
+        for (std::size_t k = 0; k < fft_size; ++k) {
+            const float re = (cross_re[k] * reference_re[k])
+                           + (cross_im[k] * reference_im[k]);
+            const float im = (cross_im[k] * reference_re[k])
+                           - (cross_re[k] * reference_im[k]);
+            const float inverse_magnitude =
+                1.0f / (std::sqrt((re * re) + (im * im)) + 1e-12f);
+
+            cross_re[k] = re * inverse_magnitude;
+            cross_im[k] = im * inverse_magnitude;
+        }
+
+        fft.inverse(cross_re, cross_im);
+
+        // peak over lags within the steerable range, circularly indexed
+        const long max_lag = static_cast<long>(max_delay_size);
+        long best = 0;
+
+        for (long lag = -max_lag; lag <= max_lag; ++lag)
+            if (correlation(lag) > correlation(best))
+                best = lag;
+
+        // parabolic refinement
+        const float left   = correlation(best - 1);
+        const float middle = correlation(best);
+        const float right  = correlation(best + 1);
+        const float denominator = left - (2.0f * middle) + right;
+        const float offset = (denominator < 0.0f)
+                           ? (0.5f * (left - right) / denominator)
+                           : 0.0f;
+
+        estimate = static_cast<float>(best) + offset;
+
+        return middle >= min_peak_confidence;
+    }
+
+    float
+    correlation(const long lag) const
+    {
+        return cross_re[static_cast<std::size_t>(lag + fft_size)
+                        % fft_size];
+    }
+
+    // the channel heard last needs no delay
+    void
+    apply_arrivals()
+    {
+        arrival[0] = 0.0f;
+
+        float latest = 0.0f;
+        for (std::size_t channel = 1; channel < channel_count; ++channel)
+            if (arrival[channel] > latest)
+                latest = arrival[channel];
+
+        float delays[channel_count];
+        for (std::size_t channel = 0; channel < channel_count; ++channel) {
+            float delay = latest - arrival[channel];
+            delay = (delay < 0.0f) ? 0.0f : delay;
+            delays[channel] = (delay > max_delay_size)
+                            ? static_cast<float>(max_delay_size)
+                            : delay;
+        }
+
+        steer_delays(delays);
+    }
+
+    bool tracking;
+    std::size_t next_pair;
+    detail::Fft<fft_size> fft;
+
+    float delays[channel_count];
+    float arrival[channel_count] = {};
+    float taps[channel_count][tap_count];
+    std::size_t offsets[channel_count]; // line index of delayed frame 0
+    line_type lines[channel_count];
+
+    line_type reference_re;
+    line_type reference_im;
+    line_type cross_re;
+    line_type cross_im;
+}; // class Beamformer
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_BEAMFORMER_HPP
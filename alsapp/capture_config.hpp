@@ -0,0 +1,124 @@
+#ifndef ALSAPP_CAPTURE_CONFIG_HPP
+#define ALSAPP_CAPTURE_CONFIG_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/alsa_interface.h"  // snd_pcm_format_t, snd_pcm_uframes_t
+#include "alsapp/detail/sample_traits.hpp" // alsapp::detail::SampleTraits
+#include <cstddef>                         // std::size_t
+#include <cstdint>                         // std::uint64_t
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+namespace detail {
+
+constexpr bool
+is_power_of_two(const std::uint64_t value)
+{
+    return (value != 0) && ((value & (value - 1)) == 0);
+}
+
+constexpr std::uint64_t
+divide_rounding_up(const std::uint64_t dividend,
+                   const std::uint64_t divisor)
+{
+    return (dividend / divisor) + ((dividend % divisor) != 0);
+}
+
+} // namespace detail
+
+
+// A capture format fixed at compile time, with every size and duration
+// derived from it as a constant expression.  Invalid formats fail to
+// compile, as do buffers and latency budgets that don't fit them.
+template<typename Sample,
+         unsigned int SampleRate,
+         unsigned int ChannelCount,
+         snd_pcm_uframes_t PeriodFrameSize>
+struct CaptureConfig
+{
+    typedef Sample sample_type;
+
+    static constexpr snd_pcm_format_t sample_format =
+        detail::SampleTraits<Sample>::sample_format;
+    static constexpr unsigned int sample_rate            = SampleRate;
+    static constexpr unsigned int channel_count          = ChannelCount;
+    static constexpr snd_pcm_uframes_t period_frame_size = PeriodFrameSize;
+
+    // bytes
+    static constexpr std::size_t frame_size  = sizeof(Sample) * channel_count;
+    static constexpr std::size_t period_size = frame_size * period_frame_size;
+    static constexpr std::size_t byte_rate   = frame_size * sample_rate;
+
+    // capture latency added by waiting for a whole period
+    static constexpr std::uint64_t period_usec =
+        detail::divide_rounding_up(std::uint64_t(period_frame_size) * 1000000,
+                                   sample_rate);
+
+    static_assert(sample_rate > 0, "sample rate must be positive");
+    static_assert(channel_count > 0, "channel count must be positive");
+    static_assert(period_frame_size > 0, "period must not be empty");
+
+    // number of periods required to record 'milliseconds' of sound
+    static constexpr std::size_t
+    periods_for_msec(const std::size_t milliseconds)
+    {
+        return detail::divide_rounding_up(std::uint64_t(milliseconds)
+                                          * sample_rate,
+                                          std::uint64_t(period_frame_size)
+                                          * 1000);
+    }
+
+    static constexpr std::size_t
+    periods_for_sec(const std::size_t seconds)
+    {
+        return periods_for_msec(seconds * 1000);
+    }
+
+    // whether 'milliseconds' of sound is a whole number of periods
+    static constexpr bool
+    is_whole_periods(const std::size_t milliseconds)
+    {
+        return ((std::uint64_t(milliseconds) * sample_rate)
+                % (std::uint64_t(period_frame_size) * 1000)) == 0;
+    }
+
+    // a buffer of exactly 'milliseconds' of sound
+    template<std::size_t milliseconds>
+    struct Buffer
+    {
+        static_assert(milliseconds > 0, "buffer must not be empty");
+        static_assert(is_whole_periods(milliseconds),
+                      "buffer must hold a whole number of periods");
+
+        static constexpr std::size_t period_count =
+            periods_for_msec(milliseconds);
+        static constexpr std::size_t size = period_count * period_size;
+
+        typedef char period_type[period_size];
+        typedef period_type type[period_count];
+    }; // struct Buffer
+}; // struct CaptureConfig
+
+
+// Fails to compile unless 'period_count' periods of 'Config' (e.g. a
+// processing pipeline's block delay) arrive within 'budget_usec'
+template<typename Config,
+         std::uint64_t budget_usec,
+         std::size_t period_count = 1>
+struct LatencyBudget
+{
+    static constexpr std::uint64_t latency_usec =
+        Config::period_usec * period_count;
+
+    static_assert(latency_usec <= budget_usec,
+                  "capture latency exceeds the budget");
+
+    static constexpr std::uint64_t headroom_usec = budget_usec - latency_usec;
+}; // struct LatencyBudget
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_CAPTURE_CONFIG_HPP
@@ -0,0 +1,112 @@
+#ifndef ALSAPP_CHANNELS_HPP
+#define ALSAPP_CHANNELS_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/sample_traits.hpp" // alsapp::detail::SampleTraits
+#include <cstddef>                         // std::size_t
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// Channel layout kernels.  The channel count is a template parameter so every
+// inner loop has a constant stride and trip count; compilers turn these into
+// vector shuffles for the usual 2/4/8 channel layouts without per-ISA code.
+
+// interleaved[frame * channel_count + channel] -> planar[channel][frame]
+template<std::size_t channel_count,
+         typename Sample>
+inline void
+deinterleave(const Sample *const interleaved,
+             const std::size_t frame_count,
+             Sample *const *const planar)
+{
+    for (std::size_t channel = 0; channel < channel_count; ++channel) {
+        Sample *const output = planar[channel];
+
+        for (std::size_t frame = 0; frame < frame_count; ++frame)
+            output[frame] = interleaved[(frame * channel_count) + channel];
+    }
+}
+
+// planar[channel][frame] -> interleaved[frame * channel_count + channel]
+template<std::size_t channel_count,
+         typename Sample>
+inline void
+interleave(const Sample *const *const planar,
+           const std::size_t frame_count,
+           Sample *const interleaved)
+{
+    for (std::size_t channel = 0; channel < channel_count; ++channel) {
+        const Sample *const input = planar[channel];
+
+        for (std::size_t frame = 0; frame < frame_count; ++frame)
+            interleaved[(frame * channel_count) + channel] = input[frame];
+    }
+}
+
+// copy one channel out of an interleaved buffer
+template<std::size_t channel_count,
+         typename Sample>
+inline void
+select_channel(const Sample *const interleaved,
+               const std::size_t frame_count,
+               const std::size_t channel,
+               Sample *const output)
+{
+    for (std::size_t frame = 0; frame < frame_count; ++frame)
+        output[frame] = interleaved[(frame * channel_count) + channel];
+}
+
+// average all channels of an interleaved buffer into one
+template<std::size_t channel_count,
+         typename Sample>
+inline void
+downmix(const Sample *const interleaved,
+        const std::size_t frame_count,
+        Sample *const output)
+{
+    typedef typename detail::SampleTraits<Sample>::accumulator_type
+        accumulator_type;
+
+    for (std::size_t frame = 0; frame < frame_count; ++frame) {
+        accumulator_type sum = 0;
+
+        for (std::size_t channel = 0; channel < channel_count; ++channel)
+            sum += interleaved[(frame * channel_count) + channel];
+
+        // divide signed, a negative sum would convert to std::size_t
+        output[frame] = static_cast<Sample>(
+            sum / static_cast<accumulator_type>(channel_count)
+        );
+    }
+}
+
+// average all channels of a planar buffer into one
+template<std::size_t channel_count,
+         typename Sample>
+inline void
+downmix_planar(const Sample *const *const planar,
+               const std::size_t frame_count,
+               Sample *const output)
+{
+    typedef typename detail::SampleTraits<Sample>::accumulator_type
+        accumulator_type;
+
+    for (std::size_t frame = 0; frame < frame_count; ++frame) {
+        accumulator_type sum = 0;
+
+        for (std::size_t channel = 0; channel < channel_count; ++channel)
+            sum += planar[channel][frame];
+
+        output[frame] = static_cast<Sample>(
+            sum / static_cast<accumulator_type>(channel_count)
+        );
+    }
+}
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_CHANNELS_HPP
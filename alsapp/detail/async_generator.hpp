@@ -0,0 +1,156 @@
+#ifndef ALSAPP_DETAIL_ASYNC_GENERATOR_HPP
+#define ALSAPP_DETAIL_ASYNC_GENERATOR_HPP
+
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include <coroutine> // std::coroutine_handle, std::suspend_always
+#include <exception> // std::exception_ptr, std::rethrow_exception
+#include <utility>   // std::exchange
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+namespace detail {
+
+// A coroutine that may co_await and co_yields values of 'Value' to one
+// consumer, which pulls them with 'co_await generator.next()'.  Control
+// passes between the two by symmetric transfer, so yielding costs no more
+// than a function call and never touches the reactor.
+template<typename Value>
+class AsyncGenerator
+{
+public:
+    struct promise_type;
+
+    typedef std::coroutine_handle<promise_type> handle_type;
+
+    struct promise_type
+    {
+        // hands control back to whoever called next()
+        struct TransferToConsumer
+        {
+            bool
+            await_ready() const noexcept
+            {
+                return false;
+            }
+
+            std::coroutine_handle<>
+            await_suspend(const handle_type generator) const noexcept
+            {
+                return generator.promise().consumer;
+            }
+
+            void
+            await_resume() const noexcept
+            {}
+        }; // struct TransferToConsumer
+
+        AsyncGenerator
+        get_return_object() noexcept
+        {
+            return AsyncGenerator(handle_type::from_promise(*this));
+        }
+
+        std::suspend_always
+        initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        TransferToConsumer
+        final_suspend() noexcept
+        {
+            done = true;
+            return {};
+        }
+
+        TransferToConsumer
+        yield_value(const Value &yielded) noexcept
+        {
+            value = yielded;
+            return {};
+        }
+
+        void
+        return_void() const noexcept
+        {}
+
+        void
+        unhandled_exception() noexcept
+        {
+            exception = std::current_exception();
+        }
+
+        Value value;
+        bool done = false;
+        std::coroutine_handle<> consumer;
+        std::exception_ptr exception;
+    }; // struct promise_type
+
+    // resumes the generator, results in the next value or null when finished
+    struct Next
+    {
+        bool
+        await_ready() const noexcept
+        {
+            return false;
+        }
+
+        std::coroutine_handle<>
+        await_suspend(const std::coroutine_handle<> consumer) const noexcept
+        {
+            generator.promise().consumer = consumer;
+            return generator;
+        }
+
+        const Value *
+        await_resume() const
+        {
+            promise_type &promise = generator.promise();
+
+            if (promise.exception)
+                std::rethrow_exception(std::exchange(promise.exception,
+                                                     nullptr));
+
+            return promise.done ? nullptr : &promise.value;
+        }
+
+        handle_type generator;
+    }; // struct Next
+
+    AsyncGenerator(AsyncGenerator &&other) noexcept
+        : generator(std::exchange(other.generator, nullptr))
+    {}
+
+    AsyncGenerator(const AsyncGenerator &)            = delete;
+    AsyncGenerator &operator=(const AsyncGenerator &) = delete;
+
+    ~AsyncGenerator()
+    {
+        if (generator)
+            generator.destroy();
+    }
+
+    // not to be awaited again once it has resulted in null
+    Next
+    next() const noexcept
+    {
+        return Next{generator};
+    }
+
+
+private:
+    explicit AsyncGenerator(const handle_type generator) noexcept
+        : generator(generator)
+    {}
+
+    handle_type generator;
+}; // class AsyncGenerator
+
+} // namespace detail
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_DETAIL_ASYNC_GENERATOR_HPP
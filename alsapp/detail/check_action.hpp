@@ -4,6 +4,8 @@
 // EXTERNAL DEPENDENCIES
 // =============================================================================
 #include "alsapp/detail/alsa_interface.h" // snd_strerror
+#include <cstdio>                         // std::fprintf, stderr
+#include <cstdlib>                        // std::abort
 #include <stdexcept>                      // std::runtime_error
 #include <string>                         // std::string
 
@@ -15,16 +17,24 @@ namespace alsapp {
 namespace detail {
 
 // throw runtime error if action failed
+//
+// Without exceptions (-fno-exceptions) the throwing API aborts instead; use
+// the std::error_code overloads there.
 inline void
 check_action(const char *const action,
              const int status)
 {
     if (status < 0) {
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
         std::string what_arg("failed to ");
         what_arg += action;
         what_arg += ": ";
         what_arg += snd_strerror(status);
         throw std::runtime_error(what_arg);
+#else
+        std::fprintf(stderr, "failed to %s: %s\n", action, snd_strerror(status));
+        std::abort();
+#endif // if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
     }
 }
 
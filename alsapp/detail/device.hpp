@@ -5,6 +5,8 @@
 // =============================================================================
 #include "alsapp/detail/alsa_interface.h" // snd_pcm_[[stream]_t|open|close]
 #include "alsapp/detail/check_action.hpp" // alsapp::detail::check_action
+#include "alsapp/error.hpp"               // alsapp::make_alsa_error
+#include <system_error>                   // std::error_code
 
 
 
@@ -27,9 +29,48 @@ public:
                                   open_mode));
     }
 
+    // no-throw open, 'error' is set if the device could not be opened
+    Device(const char *const name,
+           const snd_pcm_stream_t stream_mode,
+           const int open_mode,
+           std::error_code &error) noexcept
+        : handle(nullptr)
+    {
+        error = make_alsa_error(snd_pcm_open(&handle,
+                                             name,
+                                             stream_mode,
+                                             open_mode));
+        if (error)
+            handle = nullptr;
+    }
+
     ~Device()
     {
-        (void) snd_pcm_close(handle);
+        close();
+    }
+
+    // move-only: the handle has exactly one owner, a moved-from Device may
+    // only be assigned to or destroyed
+    Device(const Device &)            = delete;
+    Device &operator=(const Device &) = delete;
+
+    Device(Device &&other) noexcept
+        : handle(other.handle)
+    {
+        other.handle = nullptr;
+    }
+
+    Device &
+    operator=(Device &&other) noexcept
+    {
+        if (this != &other) {
+            close();
+
+            handle       = other.handle;
+            other.handle = nullptr;
+        }
+
+        return *this;
     }
 
 
@@ -41,6 +82,17 @@ protected:
 
 
 private:
+    void
+    close() noexcept
+    {
+        if (handle != nullptr) {
+            // stop at once, discarding unread or unplayed frames (drain
+            // first to keep them)
+            (void) snd_pcm_drop(handle);
+            (void) snd_pcm_close(handle);
+        }
+    }
+
     snd_pcm_t *handle;
 }; // class Device
 
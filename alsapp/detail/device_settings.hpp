@@ -5,6 +5,8 @@
 // =============================================================================
 #include "alsapp/detail/alsa_interface.h" // snd_pcm_*
 #include "alsapp/detail/check_action.hpp" // alsapp::detail::check_action
+#include "alsapp/error.hpp"               // alsapp::make_alsa_error
+#include <system_error>                   // std::error_code
 
 
 
@@ -27,9 +29,49 @@ public:
                                                    hw_params_handle));
     }
 
+    // no-throw construction, 'error' is set on failure
+    DeviceSettings(snd_pcm_t *const device_handle,
+                   std::error_code &error) noexcept
+        : device_handle(device_handle),
+          hw_params_handle(nullptr)
+    {
+        error = make_alsa_error(snd_pcm_hw_params_malloc(&hw_params_handle));
+
+        if (!error)
+            error = make_alsa_error(snd_pcm_hw_params_any(device_handle,
+                                                          hw_params_handle));
+    }
+
     ~DeviceSettings()
     {
-        snd_pcm_hw_params_free(hw_params_handle);
+        if (hw_params_handle != nullptr)
+            snd_pcm_hw_params_free(hw_params_handle);
+    }
+
+    // move-only, like the Device it configures
+    DeviceSettings(const DeviceSettings &)            = delete;
+    DeviceSettings &operator=(const DeviceSettings &) = delete;
+
+    DeviceSettings(DeviceSettings &&other) noexcept
+        : device_handle(other.device_handle),
+          hw_params_handle(other.hw_params_handle)
+    {
+        other.hw_params_handle = nullptr;
+    }
+
+    DeviceSettings &
+    operator=(DeviceSettings &&other) noexcept
+    {
+        if (this != &other) {
+            if (hw_params_handle != nullptr)
+                snd_pcm_hw_params_free(hw_params_handle);
+
+            device_handle          = other.device_handle;
+            hw_params_handle       = other.hw_params_handle;
+            other.hw_params_handle = nullptr;
+        }
+
+        return *this;
     }
 
     void
@@ -41,6 +83,15 @@ public:
                                                           access_mode));
     }
 
+    void
+    set_access_mode(const snd_pcm_access_t access_mode,
+                    std::error_code &error) noexcept
+    {
+        error = make_alsa_error(snd_pcm_hw_params_set_access(device_handle,
+                                                             hw_params_handle,
+                                                             access_mode));
+    }
+
     void
     set_sample_format(const snd_pcm_format_t sample_format)
     {
@@ -50,6 +101,15 @@ public:
                                                           sample_format));
     }
 
+    void
+    set_sample_format(const snd_pcm_format_t sample_format,
+                      std::error_code &error) noexcept
+    {
+        error = make_alsa_error(snd_pcm_hw_params_set_format(device_handle,
+                                                             hw_params_handle,
+                                                             sample_format));
+    }
+
     void
     set_channel_count(const unsigned int count_channels)
     {
@@ -59,6 +119,15 @@ public:
                                                             count_channels));
     }
 
+    void
+    set_channel_count(const unsigned int count_channels,
+                      std::error_code &error) noexcept
+    {
+        error = make_alsa_error(snd_pcm_hw_params_set_channels(device_handle,
+                                                               hw_params_handle,
+                                                               count_channels));
+    }
+
     void
     set_sample_rate(const unsigned int sample_rate)
     {
@@ -69,6 +138,16 @@ public:
                                                         0));
     }
 
+    void
+    set_sample_rate(const unsigned int sample_rate,
+                    std::error_code &error) noexcept
+    {
+        error = make_alsa_error(snd_pcm_hw_params_set_rate(device_handle,
+                                                           hw_params_handle,
+                                                           sample_rate,
+                                                           0));
+    }
+
     void
     set_period_frame_size(const snd_pcm_uframes_t period_frame_size)
     {
@@ -81,6 +160,177 @@ public:
         );
     }
 
+    void
+    set_period_frame_size(const snd_pcm_uframes_t period_frame_size,
+                          std::error_code &error) noexcept
+    {
+        error = make_alsa_error(
+            snd_pcm_hw_params_set_period_size(device_handle,
+                                              hw_params_handle,
+                                              period_frame_size,
+                                              0)
+        );
+    }
+
+    void
+    set_rate_resample(const bool resample)
+    {
+        detail::check_action("set rate resampling",
+                             snd_pcm_hw_params_set_rate_resample(device_handle,
+                                                                 hw_params_handle,
+                                                                 resample));
+    }
+
+    // request a buffer (frame) size, returns the nearest supported size
+    snd_pcm_uframes_t
+    set_buffer_frame_size_near(snd_pcm_uframes_t buffer_frame_size)
+    {
+        detail::check_action(
+            "set buffer (frame) size",
+            snd_pcm_hw_params_set_buffer_size_near(device_handle,
+                                                   hw_params_handle,
+                                                   &buffer_frame_size)
+        );
+
+        return buffer_frame_size;
+    }
+
+    // request a period (frame) size, returns the nearest supported size
+    snd_pcm_uframes_t
+    set_period_frame_size_near(snd_pcm_uframes_t period_frame_size)
+    {
+        detail::check_action(
+            "set period (frame) size",
+            snd_pcm_hw_params_set_period_size_near(device_handle,
+                                                   hw_params_handle,
+                                                   &period_frame_size,
+                                                   nullptr)
+        );
+
+        return period_frame_size;
+    }
+
+    snd_pcm_uframes_t
+    period_frame_size() const
+    {
+        snd_pcm_uframes_t period_frame_size;
+
+        detail::check_action(
+            "get period (frame) size",
+            snd_pcm_hw_params_get_period_size(hw_params_handle,
+                                              &period_frame_size,
+                                              nullptr)
+        );
+
+        return period_frame_size;
+    }
+
+    // period duration in microseconds
+    unsigned int
+    period_time() const
+    {
+        unsigned int period_time;
+
+        detail::check_action("get period time",
+                             snd_pcm_hw_params_get_period_time(hw_params_handle,
+                                                               &period_time,
+                                                               nullptr));
+
+        return period_time;
+    }
+
+    snd_pcm_uframes_t
+    buffer_frame_size() const
+    {
+        snd_pcm_uframes_t buffer_frame_size;
+
+        detail::check_action(
+            "get buffer (frame) size",
+            snd_pcm_hw_params_get_buffer_size(hw_params_handle,
+                                              &buffer_frame_size)
+        );
+
+        return buffer_frame_size;
+    }
+
+    unsigned int
+    min_period_count() const
+    {
+        unsigned int period_count;
+
+        detail::check_action(
+            "get minimum period count",
+            snd_pcm_hw_params_get_periods_min(hw_params_handle,
+                                              &period_count,
+                                              nullptr)
+        );
+
+        return period_count;
+    }
+
+    // whether the configuration space still allows 'sample_format'
+    bool
+    supports_sample_format(const snd_pcm_format_t sample_format) const
+    {
+        return snd_pcm_hw_params_test_format(device_handle,
+                                             hw_params_handle,
+                                             sample_format) == 0;
+    }
+
+    unsigned int
+    min_channel_count() const
+    {
+        unsigned int count_channels;
+
+        detail::check_action(
+            "get minimum channel count",
+            snd_pcm_hw_params_get_channels_min(hw_params_handle,
+                                               &count_channels)
+        );
+
+        return count_channels;
+    }
+
+    unsigned int
+    max_channel_count() const
+    {
+        unsigned int count_channels;
+
+        detail::check_action(
+            "get maximum channel count",
+            snd_pcm_hw_params_get_channels_max(hw_params_handle,
+                                               &count_channels)
+        );
+
+        return count_channels;
+    }
+
+    unsigned int
+    min_sample_rate() const
+    {
+        unsigned int sample_rate;
+
+        detail::check_action("get minimum sample rate",
+                             snd_pcm_hw_params_get_rate_min(hw_params_handle,
+                                                            &sample_rate,
+                                                            nullptr));
+
+        return sample_rate;
+    }
+
+    unsigned int
+    max_sample_rate() const
+    {
+        unsigned int sample_rate;
+
+        detail::check_action("get maximum sample rate",
+                             snd_pcm_hw_params_get_rate_max(hw_params_handle,
+                                                            &sample_rate,
+                                                            nullptr));
+
+        return sample_rate;
+    }
+
     void
     finalize()
     {
@@ -89,9 +339,16 @@ public:
                                                hw_params_handle));
     }
 
+    void
+    finalize(std::error_code &error) noexcept
+    {
+        error = make_alsa_error(snd_pcm_hw_params(device_handle,
+                                                  hw_params_handle));
+    }
+
 
 private:
-    snd_pcm_t *const device_handle;
+    snd_pcm_t *device_handle;
     snd_pcm_hw_params_t *hw_params_handle;
 }; // class DeviceSettings
 
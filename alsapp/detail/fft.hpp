@@ -0,0 +1,131 @@
+#ifndef ALSAPP_DETAIL_FFT_HPP
+#define ALSAPP_DETAIL_FFT_HPP
+
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include <cmath>   // std::cos, std::sin
+#include <cstddef> // std::size_t
+#include <utility> // std::swap
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+namespace detail {
+
+// In-place radix-2 complex FFT over split real/imaginary arrays.  Twiddles are
+// laid out contiguously per stage so every butterfly loop walks unit-stride
+// arrays and auto-vectorizes.  Forward is unscaled, inverse scales by 1/size.
+template<std::size_t size>
+class Fft
+{
+    static_assert((size >= 2) && ((size & (size - 1)) == 0),
+                  "FFT size must be a power of two");
+
+public:
+    Fft()
+    {
+        for (std::size_t i = 0; i < size; ++i) {
+            std::size_t reversed = 0;
+            for (std::size_t bit = 1, mirror = size >> 1;
+                 bit < size;
+                 bit <<= 1, mirror >>= 1)
+                if (i & bit)
+                    reversed |= mirror;
+
+            bit_reversed[i] = reversed;
+        }
+
+        const double tau = 6.283185307179586476925286766559;
+
+        std::size_t offset = 0;
+        for (std::size_t span = 2; span <= size; span <<= 1) {
+            const std::size_t half = span / 2;
+
+            for (std::size_t j = 0; j < half; ++j) {
+                const double angle = -tau * static_cast<double>(j)
+                                   / static_cast<double>(span);
+
+                twiddle_re[offset + j] = static_cast<float>(std::cos(angle));
+                twiddle_im[offset + j] = static_cast<float>(std::sin(angle));
+            }
+
+            offset += half;
+        }
+    }
+
+    void
+    forward(float *const re,
+            float *const im) const
+    {
+        transform(re, im, 1.0f);
+    }
+
+    void
+    inverse(float *const re,
+            float *const im) const
+    {
+        transform(re, im, -1.0f);
+
+        const float scale = 1.0f / static_cast<float>(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            re[i] *= scale;
+            im[i] *= scale;
+        }
+    }
+
+
+private:
+    // sign = 1 for e^(-i...), -1 for the conjugate transform
+    void
+    transform(float *const re,
+              float *const im,
+              const float sign) const
+    {
+        for (std::size_t i = 0; i < size; ++i) {
+            const std::size_t j = bit_reversed[i];
+            if (j > i) {
+                std::swap(re[i], re[j]);
+                std::swap(im[i], im[j]);
+            }
+        }
+
+        std::size_t offset = 0;
+        for (std::size_t span = 2; span <= size; span <<= 1) {
+            const std::size_t half = span / 2;
+            const float *const w_re = &twiddle_re[offset];
+            const float *const w_im = &twiddle_im[offset];
+
+            for (std::size_t start = 0; start < size; start += span) {
+                float *const a_re = re + start;
+                float *const a_im = im + start;
+                float *const b_re = a_re + half;
+                float *const b_im = a_im + half;
+
+                for (std::size_t j = 0; j < half; ++j) {
+                    const float wr = w_re[j];
+                    const float wi = sign * w_im[j];
+                    const float t_re = (b_re[j] * wr) - (b_im[j] * wi);
+                    const float t_im = (b_re[j] * wi) + (b_im[j] * wr);
+
+                    b_re[j] = a_re[j] - t_re;
+                    b_im[j] = a_im[j] - t_im;
+                    a_re[j] += t_re;
+                    a_im[j] += t_im;
+                }
+            }
+
+            offset += half;
+        }
+    }
+
+    std::size_t bit_reversed[size];
+    float twiddle_re[size]; // size - 1 used
+    float twiddle_im[size];
+}; // class Fft
+
+} // namespace detail
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_DETAIL_FFT_HPP
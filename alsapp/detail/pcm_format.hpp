@@ -0,0 +1,86 @@
+#ifndef ALSAPP_DETAIL_PCM_FORMAT_HPP
+#define ALSAPP_DETAIL_PCM_FORMAT_HPP
+
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/capture_config.hpp"         // alsapp::CaptureConfig
+#include "alsapp/detail/alsa_interface.h"    // snd_pcm_*, SND_PCM_*
+#include "alsapp/detail/device_settings.hpp" // alsapp::detail::DeviceSettings
+#include <cstddef>                           // std::size_t
+#include <cstdint>                           // std::int16_t
+#include <system_error>                      // std::error_code
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+namespace detail {
+
+// audio format shared by every alsapp stream
+struct PcmFormat
+{
+    // open stream in synchronous, blocking mode
+    static const int open_mode = 0;
+
+    // grant access to interleaved channel read (and write)
+    static const snd_pcm_access_t access_mode = SND_PCM_ACCESS_RW_INTERLEAVED;
+
+    // signed, 16-bit, little-endian samples, one channel (mono), sampled at
+    // 16000 HZ, 128 frames per period
+    typedef CaptureConfig<std::int16_t, 16000, 1, 128> config_type;
+
+    static const snd_pcm_format_t sample_format = config_type::sample_format;
+    typedef config_type::sample_type sample_type;
+
+    static const unsigned int channel_count = config_type::channel_count;
+    typedef sample_type frame_type[channel_count];
+
+    static const unsigned int sample_rate = config_type::sample_rate;
+
+    static const snd_pcm_uframes_t period_frame_size =
+        config_type::period_frame_size;
+
+    // sizeof(period_type)
+    static const std::size_t period_size = config_type::period_size;
+
+    typedef char period_type[period_size]; // audio units
+
+    // apply everything but the period size
+    static void
+    apply_stream_settings(DeviceSettings &settings)
+    {
+        settings.set_access_mode(access_mode);
+        settings.set_sample_format(sample_format);
+        settings.set_channel_count(channel_count);
+        settings.set_sample_rate(sample_rate);
+    }
+
+    static void
+    apply(DeviceSettings &settings)
+    {
+        apply_stream_settings(settings);
+        settings.set_period_frame_size(period_frame_size);
+    }
+
+    // no-throw apply, stops at the first setting that fails
+    static void
+    apply(DeviceSettings &settings,
+          std::error_code &error) noexcept
+    {
+        settings.set_access_mode(access_mode, error);
+        if (!error)
+            settings.set_sample_format(sample_format, error);
+        if (!error)
+            settings.set_channel_count(channel_count, error);
+        if (!error)
+            settings.set_sample_rate(sample_rate, error);
+        if (!error)
+            settings.set_period_frame_size(period_frame_size, error);
+    }
+}; // struct PcmFormat
+
+} // namespace detail
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_DETAIL_PCM_FORMAT_HPP
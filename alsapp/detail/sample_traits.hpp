@@ -0,0 +1,48 @@
+#ifndef ALSAPP_DETAIL_SAMPLE_TRAITS_HPP
+#define ALSAPP_DETAIL_SAMPLE_TRAITS_HPP
+
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/alsa_interface.h" // snd_pcm_format_t, SND_PCM_FORMAT_*
+#include <cstdint>                        // std::int[16|32]_t
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+namespace detail {
+
+// ALSA format, widening accumulator and value of 1.0 (full scale) of a native
+// sample type (little-endian hosts)
+template<typename Sample>
+struct SampleTraits;
+
+template<>
+struct SampleTraits<std::int16_t>
+{
+    static const snd_pcm_format_t sample_format = SND_PCM_FORMAT_S16_LE;
+    typedef std::int32_t accumulator_type;
+    static constexpr float full_scale = 32768.0f;
+}; // struct SampleTraits<std::int16_t>
+
+template<>
+struct SampleTraits<std::int32_t>
+{
+    static const snd_pcm_format_t sample_format = SND_PCM_FORMAT_S32_LE;
+    typedef std::int64_t accumulator_type;
+    static constexpr float full_scale = 2147483648.0f;
+}; // struct SampleTraits<std::int32_t>
+
+template<>
+struct SampleTraits<float>
+{
+    static const snd_pcm_format_t sample_format = SND_PCM_FORMAT_FLOAT_LE;
+    typedef float accumulator_type;
+    static constexpr float full_scale = 1.0f;
+}; // struct SampleTraits<float>
+
+} // namespace detail
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_DETAIL_SAMPLE_TRAITS_HPP
@@ -0,0 +1,75 @@
+#ifndef ALSAPP_DETAIL_SOFTWARE_SETTINGS_HPP
+#define ALSAPP_DETAIL_SOFTWARE_SETTINGS_HPP
+
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/alsa_interface.h" // snd_pcm_sw_params_*
+#include "alsapp/detail/check_action.hpp" // alsapp::detail::check_action
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+namespace detail {
+
+// software (transfer) parameters, applied after DeviceSettings::finalize
+class SoftwareSettings
+{
+public:
+    SoftwareSettings(snd_pcm_t *const device_handle)
+        : device_handle(device_handle)
+    {
+        detail::check_action("allocate software parameters structure",
+                             snd_pcm_sw_params_malloc(&sw_params_handle));
+
+        detail::check_action("read current software parameters",
+                             snd_pcm_sw_params_current(device_handle,
+                                                       sw_params_handle));
+    }
+
+    ~SoftwareSettings()
+    {
+        snd_pcm_sw_params_free(sw_params_handle);
+    }
+
+    void
+    set_start_threshold(const snd_pcm_uframes_t frame_count)
+    {
+        detail::check_action(
+            "set start threshold",
+            snd_pcm_sw_params_set_start_threshold(device_handle,
+                                                  sw_params_handle,
+                                                  frame_count)
+        );
+    }
+
+    void
+    set_avail_min(const snd_pcm_uframes_t frame_count)
+    {
+        detail::check_action(
+            "set minimum available frames",
+            snd_pcm_sw_params_set_avail_min(device_handle,
+                                            sw_params_handle,
+                                            frame_count)
+        );
+    }
+
+    void
+    finalize()
+    {
+        detail::check_action("finalize software settings",
+                             snd_pcm_sw_params(device_handle,
+                                               sw_params_handle));
+    }
+
+
+private:
+    snd_pcm_t *const device_handle;
+    snd_pcm_sw_params_t *sw_params_handle;
+}; // class SoftwareSettings
+
+} // namespace detail
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_DETAIL_SOFTWARE_SETTINGS_HPP
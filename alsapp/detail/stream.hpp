@@ -0,0 +1,35 @@
+#ifndef ALSAPP_DETAIL_STREAM_HPP
+#define ALSAPP_DETAIL_STREAM_HPP
+
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/alsa_interface.h" // snd_pcm_[t|stream_t]
+#include "alsapp/detail/device.hpp"       // alsapp::detail::Device
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+namespace detail {
+
+// a Device whose handle is visible to its owner, for classes that manage
+// more than one stream or only probe a device
+class Stream : public Device
+{
+public:
+    Stream(const char *const name,
+           const snd_pcm_stream_t stream_mode,
+           const int open_mode = 0)
+        : Device(name,
+                 stream_mode,
+                 open_mode)
+    {}
+
+    using Device::operator snd_pcm_t *;
+}; // class Stream
+
+} // namespace detail
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_DETAIL_STREAM_HPP
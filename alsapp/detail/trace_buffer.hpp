@@ -0,0 +1,85 @@
+#ifndef ALSAPP_DETAIL_TRACE_BUFFER_HPP
+#define ALSAPP_DETAIL_TRACE_BUFFER_HPP
+
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include <atomic>  // std::atomic, std::atomic_thread_fence
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <vector>  // std::vector
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+namespace detail {
+
+// Fixed-capacity ring of trace events written by exactly one thread and read
+// by any number of dumping threads.  The writer never blocks or allocates: once
+// full, the oldest events are overwritten.
+template<typename EventType,
+         std::size_t capacity>
+class TraceBuffer
+{
+    static_assert((capacity & (capacity - 1)) == 0,
+                  "trace buffer capacity must be a power of two");
+
+public:
+    TraceBuffer()
+        : head(0)
+    {}
+
+    // writer thread only
+    void
+    push(const EventType &event) noexcept
+    {
+        const std::uint64_t index = head.load(std::memory_order_relaxed);
+
+        events[index & (capacity - 1)] = event;
+
+        head.store(index + 1, std::memory_order_release);
+    }
+
+    // copy out the retained events in write order, returns count copied
+    template<typename OutputIterator>
+    std::size_t
+    snapshot(OutputIterator output) const
+    {
+        const std::uint64_t end   = head.load(std::memory_order_acquire);
+        const std::uint64_t begin = (end > capacity) ? (end - capacity) : 0;
+
+        std::vector<EventType> copy;
+        copy.reserve(static_cast<std::size_t>(end - begin));
+
+        for (std::uint64_t index = begin; index < end; ++index)
+            copy.push_back(events[index & (capacity - 1)]);
+
+        // discard whatever the writer lapped while we were copying, and the
+        // slot of index 'lapped', which it may be writing right now
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const std::uint64_t lapped = head.load(std::memory_order_relaxed);
+        const std::uint64_t valid  = ((lapped + 1) > capacity)
+                                   ? (lapped + 1 - capacity)
+                                   : 0;
+        const std::size_t skip = (valid > begin)
+                               ? static_cast<std::size_t>(valid - begin)
+                               : 0;
+
+        std::size_t copied = 0;
+        for (std::size_t i = skip; i < copy.size(); ++i, ++copied)
+            *output++ = copy[i];
+
+        return copied;
+    }
+
+
+private:
+    std::atomic<std::uint64_t> head;
+    EventType events[capacity];
+}; // class TraceBuffer
+
+} // namespace detail
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_DETAIL_TRACE_BUFFER_HPP
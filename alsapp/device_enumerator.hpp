@@ -0,0 +1,256 @@
+#ifndef ALSAPP_DEVICE_ENUMERATOR_HPP
+#define ALSAPP_DEVICE_ENUMERATOR_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/alsa_interface.h"    // snd_device_name_*, snd_ctl_*
+#include "alsapp/detail/check_action.hpp"    // alsapp::detail::check_action
+#include "alsapp/detail/device_settings.hpp" // alsapp::detail::DeviceSettings
+#include "alsapp/detail/stream.hpp"          // alsapp::detail::Stream
+#include <cstdlib>                           // std::free
+#include <exception>                         // std::exception
+#include <memory>                            // std::unique_ptr
+#include <string>                            // std::string, std::to_string
+#include <vector>                            // std::vector
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// a capture PCM and, if it could be opened, what it supports
+struct CaptureDeviceInfo
+{
+    std::string name;        // PCM name, as passed to Microphone
+    std::string description; // human readable
+    int card;                // sound card index, -1 for virtual PCMs
+
+    bool probed; // whether the fields below are valid (device may be busy)
+    unsigned int min_channel_count;
+    unsigned int max_channel_count;
+    unsigned int min_sample_rate;
+    unsigned int max_sample_rate;
+    std::vector<snd_pcm_format_t> sample_formats; // of those alsapp converts
+}; // struct CaptureDeviceInfo
+
+
+namespace detail {
+
+struct HintsDeleter
+{
+    void
+    operator()(void **hints) const
+    {
+        (void) snd_device_name_free_hint(hints);
+    }
+}; // struct HintsDeleter
+
+struct HintStringDeleter
+{
+    void
+    operator()(char *string) const
+    {
+        std::free(string);
+    }
+}; // struct HintStringDeleter
+
+typedef std::unique_ptr<char, HintStringDeleter> hint_string;
+
+inline std::string
+hint_value(const void *const hint,
+           const char *const id)
+{
+    const hint_string value(snd_device_name_get_hint(hint, id));
+
+    return value ? std::string(value.get()) : std::string();
+}
+
+// fill in capabilities, leaves 'probed' false if the device can't be opened
+inline void
+probe_capture_device(CaptureDeviceInfo &info)
+{
+    static const snd_pcm_format_t candidates[] = {
+        SND_PCM_FORMAT_S16_LE,
+        SND_PCM_FORMAT_S24_LE,
+        SND_PCM_FORMAT_S24_3LE,
+        SND_PCM_FORMAT_S32_LE,
+        SND_PCM_FORMAT_FLOAT_LE
+    };
+
+    try {
+        // non-blocking so a busy device fails instead of hanging the scan
+        Stream stream(info.name.c_str(),
+                      SND_PCM_STREAM_CAPTURE,
+                      SND_PCM_NONBLOCK);
+        DeviceSettings settings(stream);
+
+        info.min_channel_count = settings.min_channel_count();
+        info.max_channel_count = settings.max_channel_count();
+        info.min_sample_rate   = settings.min_sample_rate();
+        info.max_sample_rate   = settings.max_sample_rate();
+
+        for (const snd_pcm_format_t format : candidates)
+            if (settings.supports_sample_format(format))
+                info.sample_formats.push_back(format);
+
+        info.probed = true;
+
+    } catch (const std::exception &) {
+        info.probed = false;
+    }
+}
+
+class ControlHandle
+{
+public:
+    explicit ControlHandle(const std::string &name)
+    {
+        check_action("open control interface",
+                     snd_ctl_open(&handle, name.c_str(), 0));
+    }
+
+    ~ControlHandle()
+    {
+        (void) snd_ctl_close(handle);
+    }
+
+    ControlHandle(const ControlHandle &)            = delete;
+    ControlHandle &operator=(const ControlHandle &) = delete;
+
+    operator snd_ctl_t *() const
+    {
+        return handle;
+    }
+
+
+private:
+    snd_ctl_t *handle;
+}; // class ControlHandle
+
+// append the capture PCMs of sound card 'card'
+inline void
+list_card_capture_devices(const int card,
+                          snd_ctl_card_info_t *const card_info,
+                          snd_pcm_info_t *const pcm_info,
+                          const bool probe,
+                          std::vector<CaptureDeviceInfo> &devices)
+{
+    ControlHandle control("hw:" + std::to_string(card));
+
+    check_action("read card info",
+                 snd_ctl_card_info(control, card_info));
+
+    const std::string card_id   = snd_ctl_card_info_get_id(card_info);
+    const std::string card_name = snd_ctl_card_info_get_name(card_info);
+
+    int device = -1;
+    for (;;) {
+        check_action("find next PCM device",
+                     snd_ctl_pcm_next_device(control, &device));
+        if (device < 0)
+            break;
+
+        snd_pcm_info_set_device(pcm_info, static_cast<unsigned int>(device));
+        snd_pcm_info_set_subdevice(pcm_info, 0);
+        snd_pcm_info_set_stream(pcm_info, SND_PCM_STREAM_CAPTURE);
+
+        // fails for playback-only devices
+        if (snd_ctl_pcm_info(control, pcm_info) < 0)
+            continue;
+
+        CaptureDeviceInfo info = {};
+        info.name = "hw:CARD=" + card_id + ",DEV=" + std::to_string(device);
+        info.description = card_name + ": " + snd_pcm_info_get_name(pcm_info);
+        info.card = card;
+
+        if (probe)
+            probe_capture_device(info);
+
+        devices.push_back(std::move(info));
+    }
+}
+
+} // namespace detail
+
+
+// Capture PCMs from the configuration (snd_device_name_hint), including
+// virtual ones such as "default" and "dsnoop".
+inline std::vector<CaptureDeviceInfo>
+list_capture_devices(const bool probe = true)
+{
+    void **raw_hints;
+    detail::check_action("list PCM devices",
+                         snd_device_name_hint(-1, "pcm", &raw_hints));
+
+    const std::unique_ptr<void *, detail::HintsDeleter> hints(raw_hints);
+
+    std::vector<CaptureDeviceInfo> devices;
+
+    for (void **hint = hints.get(); *hint != nullptr; ++hint) {
+        // no IOID means both directions
+        const std::string direction = detail::hint_value(*hint, "IOID");
+        if (!direction.empty() && (direction != "Input"))
+            continue;
+
+        CaptureDeviceInfo info = {};
+        info.name        = detail::hint_value(*hint, "NAME");
+        info.description = detail::hint_value(*hint, "DESC");
+        info.card        = -1;
+
+        if (info.name.empty() || (info.name == "null"))
+            continue;
+
+        if (probe)
+            detail::probe_capture_device(info);
+
+        devices.push_back(std::move(info));
+    }
+
+    return devices;
+}
+
+// Capture PCMs of every sound card (control interface), named by card id
+// ("hw:CARD=<id>,DEV=<n>"), which stays stable when a USB device replugs
+// into a different card index.
+inline std::vector<CaptureDeviceInfo>
+list_capture_hardware(const bool probe = true)
+{
+    std::vector<CaptureDeviceInfo> devices;
+
+    snd_ctl_card_info_t *raw_card_info;
+    snd_pcm_info_t *raw_pcm_info;
+    detail::check_action("allocate card info",
+                         snd_ctl_card_info_malloc(&raw_card_info));
+    const std::unique_ptr<snd_ctl_card_info_t, void (*)(snd_ctl_card_info_t *)>
+        card_info(raw_card_info, &snd_ctl_card_info_free);
+    detail::check_action("allocate PCM info",
+                         snd_pcm_info_malloc(&raw_pcm_info));
+    const std::unique_ptr<snd_pcm_info_t, void (*)(snd_pcm_info_t *)>
+        pcm_info(raw_pcm_info, &snd_pcm_info_free);
+
+    int card = -1;
+    for (;;) {
+        detail::check_action("find next sound card",
+                             snd_card_next(&card));
+        if (card < 0)
+            break;
+
+        // a card removed since snd_card_next (e.g. during a hotplug
+        // rescan) fails to open, skip it
+        try {
+            detail::list_card_capture_devices(card,
+                                              card_info.get(),
+                                              pcm_info.get(),
+                                              probe,
+                                              devices);
+        } catch (const std::exception &) {
+            continue;
+        }
+    }
+
+    return devices;
+}
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_DEVICE_ENUMERATOR_HPP
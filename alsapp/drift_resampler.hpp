@@ -0,0 +1,487 @@
+#ifndef ALSAPP_DRIFT_RESAMPLER_HPP
+#define ALSAPP_DRIFT_RESAMPLER_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/pcm_format.hpp" // alsapp::detail::PcmFormat
+#include <atomic>                       // std::atomic
+#include <chrono>                       // std::chrono
+#include <cmath>                        // std::ceil, std::floor
+#include <cstddef>                      // std::[ptrdiff|size]_t
+#include <cstdint>                      // std::[u]int[16|32|64]_t
+#include <cstring>                      // std::memcpy, std::memset
+#include <stdexcept>                    // std::invalid_argument
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+namespace detail {
+
+// Proportional-integral loop driving a queue's fill level to its target by
+// adjusting how fast it is drained.  Critically damped, with a time constant
+// of 'loop_period_count' updates: a constant clock offset is tracked without
+// overshoot or steady-state error.
+class DriftController
+{
+public:
+    DriftController(const double frames_per_update,
+                    const double loop_period_count,
+                    const double max_correction)
+        : proportional_gain(2.0 / (frames_per_update * loop_period_count)),
+          integral_gain(1.0 / (frames_per_update
+                               * loop_period_count
+                               * loop_period_count)),
+          max_correction(max_correction)
+    {
+        reset();
+    }
+
+    void
+    reset() noexcept
+    {
+        integral = 0.0;
+    }
+
+    // fractional change of the drain rate for a fill error of
+    // 'error_frames' (positive when too full), clamped to the maximum
+    double
+    update(const double error_frames) noexcept
+    {
+        integral += error_frames;
+
+        double output = (proportional_gain * error_frames)
+                      + (integral_gain * integral);
+
+        // anti-windup: stop integrating while the output is saturated
+        if ((output > max_correction) || (output < -max_correction)) {
+            integral -= error_frames;
+            output = (output > 0.0) ? max_correction : -max_correction;
+        }
+
+        return output;
+    }
+
+
+private:
+    const double proportional_gain;
+    const double integral_gain;
+    const double max_correction;
+    double integral;
+}; // class DriftController
+
+
+// Catmull-Rom interpolation of outputs [begin, end) at 'offset + i * delta'
+// past input frame 'i + shift' (where input[1] is frame 0).  Loads are
+// contiguous and the loop is branch-free, so compilers vectorize it.
+inline void
+interpolate_run(const float *const input,
+                std::int16_t *const output,
+                const std::size_t begin,
+                const std::size_t end,
+                const std::ptrdiff_t shift,
+                const float offset,
+                const float delta) noexcept
+{
+    for (std::size_t i = begin; i < end; ++i) {
+        const float t = offset + (static_cast<float>(i) * delta);
+        const float *const near = &input[static_cast<std::ptrdiff_t>(i)
+                                         + shift];
+
+        const float before = near[0];
+        const float x0     = near[1];
+        const float x1     = near[2];
+        const float after  = near[3];
+
+        const float a = (0.5f * (after - before)) + (1.5f * (x0 - x1));
+        const float b = before - (2.5f * x0) + (2.0f * x1) - (0.5f * after);
+        const float c = 0.5f * (x1 - before);
+
+        float sample = (((((a * t) + b) * t) + c) * t) + x0 + 0.5f;
+        sample = (sample < -32768.0f) ? -32768.0f : sample;
+        sample = (sample >  32767.0f) ?  32767.0f : sample;
+
+        // truncation of a non-negative value rounds down
+        output[i] = static_cast<std::int16_t>(
+            static_cast<std::int32_t>(sample + 32768.0f) - 32768
+        );
+    }
+}
+
+// Interpolate 'count' outputs at 'phase + i * step' frames from 'input'
+// (where input[1] is frame 0).  'step' is within a percent or so of 1, so the
+// whole frame under each output ('i' plus a shift) only changes shift a few
+// times per call; each run of equal shift is interpolated in one pass.
+inline void
+interpolate(const float *const input,
+            std::int16_t *const output,
+            const std::size_t count,
+            const double phase,
+            const double step) noexcept
+{
+    const double delta = step - 1.0;
+    std::size_t begin = 0;
+
+    while (begin < count) {
+        const double offset = phase + (static_cast<double>(begin) * delta);
+        const double shift  = std::floor(offset);
+
+        // first output past this run, where 'offset' crosses an integer
+        double bound = static_cast<double>(count);
+        if (delta > 0.0)
+            bound = std::ceil((shift + 1.0 - phase) / delta);
+        else if (delta < 0.0)
+            bound = std::floor((shift - phase) / delta) + 1.0;
+
+        std::size_t end = count;
+        if (bound < static_cast<double>(count))
+            end = (bound > static_cast<double>(begin))
+                ? static_cast<std::size_t>(bound)
+                : (begin + 1);
+
+        interpolate_run(input,
+                        output,
+                        begin,
+                        end,
+                        static_cast<std::ptrdiff_t>(shift),
+                        static_cast<float>(phase - shift),
+                        static_cast<float>(delta));
+        begin = end;
+    }
+}
+
+// widen 'count' samples for interpolation
+inline void
+widen(const std::int16_t *const samples,
+      float *const output,
+      const std::size_t count) noexcept
+{
+    for (std::size_t i = 0; i < count; ++i)
+        output[i] = static_cast<float>(samples[i]);
+}
+
+} // namespace detail
+
+
+// Bridge between two streams running on different sample clocks, e.g. a
+// Microphone on one card feeding a Speaker (or an EchoCanceller reference)
+// on another.  Their crystals never agree exactly, so a plain queue between
+// them slowly fills up or runs dry.  Here the producer pushes periods as its
+// clock delivers them, and the consumer pulls periods as its own clock
+// demands them, resampled by a ratio within 'max_correction_ppm' of 1.  The
+// ratio comes from a PI loop holding the queue's fill level at
+// 'target_period_count' periods and changes gradually, over about
+// 'loop_time', so the pitch shift is inaudible and scheduling jitter is
+// averaged out.
+//
+// Pushes arrive a period or more at a time, so the fill level seen by the
+// consumer only moves in whole periods and drift would show up as a sudden
+// slip every few seconds.  Each push is timestamped instead (with the time
+// it was captured, if the caller knows it, e.g. from snd_pcm_status), and
+// the consumer interpolates the producer's position between its last two
+// pushes at the time of the pull.  The fill level is thus the least the
+// queue holds between pushes, however large they are.
+//
+// Single-producer, single-consumer: push() and pull() may run on different
+// threads without locking.  The queue never needs resetting, it is only
+// re-primed (with silence) if the producer stalls.
+class DriftResampler : private detail::PcmFormat
+{
+private:
+    // frames held at most (must be a power of two)
+    static const std::size_t capacity = 64 * period_frame_size;
+
+    static_assert(channel_count == 1, "interpolation assumes mono frames");
+
+
+public:
+    using detail::PcmFormat::period_type; // audio units
+
+    typedef std::chrono::steady_clock clock_type;
+
+    // Drift Resampler Settings
+    // -------------------------------------------------------------------------
+    // largest accepted clock mismatch, far above typical crystal tolerances
+    static constexpr double max_correction_limit_ppm = 10000.0;
+
+    explicit DriftResampler(
+        const std::size_t target_period_count    = 4,
+        const std::chrono::milliseconds loop_time =
+            std::chrono::milliseconds(10000),
+        const double max_correction_ppm          = 1000.0
+    )
+        : head(0),
+          tail(0),
+          stamp_sequence(0),
+          stamp_nsec(0),
+          stamp_position(0),
+          stamp_frame_count(0),
+          target_fill(static_cast<double>(target_period_count
+                                          * period_frame_size)),
+          controller(static_cast<double>(period_frame_size),
+                     (static_cast<double>(loop_time.count()) * sample_rate)
+                     / (1000.0 * period_frame_size),
+                     max_correction_ppm * 1e-6),
+          phase(0.0),
+          previous(0.0f),
+          filtered_fill(0.0),
+          running(false),
+          correction_ppm(0.0f),
+          underruns(0),
+          overflows(0)
+    {
+        if ((target_period_count == 0)
+            || ((target_period_count * period_frame_size) > (capacity / 2)))
+            throw std::invalid_argument("resampler target fill out of range");
+
+        if (loop_time.count() <= 0)
+            throw std::invalid_argument("resampler loop time must be positive");
+
+        if ((max_correction_ppm <= 0.0)
+            || (max_correction_ppm > max_correction_limit_ppm))
+            throw std::invalid_argument("resampler correction out of range");
+
+        std::memset(frames, 0, sizeof(frames));
+    }
+
+    DriftResampler(const DriftResampler &)            = delete;
+    DriftResampler &operator=(const DriftResampler &) = delete;
+
+    // producer side, 'captured' is when the last frame was captured, drops
+    // the periods that don't fit if the consumer stalled
+    bool
+    push(const period_type *const periods,
+         const std::size_t count,
+         const clock_type::time_point captured = clock_type::now()) noexcept
+    {
+        const std::uint64_t write = tail.load(std::memory_order_relaxed);
+        const std::size_t frame_count = count * period_frame_size;
+
+        if ((write + frame_count - head.load(std::memory_order_acquire))
+            > capacity) {
+            overflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // whole periods only, so a period never wraps around the queue
+        for (std::size_t i = 0; i < count; ++i)
+            std::memcpy(&frames[(write + (i * period_frame_size))
+                                & (capacity - 1)],
+                        periods[i],
+                        period_size);
+
+        tail.store(write + frame_count, std::memory_order_release);
+
+        stamp(captured, write + frame_count, frame_count);
+
+        return true;
+    }
+
+    bool
+    push(const period_type &period,
+         const clock_type::time_point captured = clock_type::now()) noexcept
+    {
+        return push(&period, 1, captured);
+    }
+
+    // Consumer side, fills 'period' for playback (or processing) at
+    // 'pulled'.  Yields silence (and returns false) while priming to the
+    // target fill, at start-up or after the producer fell behind.
+    // 'queued_frames' are frames already downstream of the consumer (e.g.
+    // snd_pcm_delay of the playback device), counted toward the fill level
+    // when known.
+    bool
+    pull(period_type &period,
+         const clock_type::time_point pulled = clock_type::now(),
+         const std::int64_t queued_frames    = 0) noexcept
+    {
+        const std::uint64_t read = head.load(std::memory_order_relaxed);
+        const std::uint64_t available = tail.load(std::memory_order_acquire)
+                                      - read;
+
+        const double fill = producer_position(pulled)
+                          - (static_cast<double>(read) + phase)
+                          + static_cast<double>(queued_frames);
+
+        if (!running) {
+            if (fill < target_fill)
+                return silence(period);
+
+            running       = true;
+            filtered_fill = fill;
+            controller.reset();
+        }
+
+        // smooth scheduling jitter well inside the loop bandwidth
+        filtered_fill += (fill - filtered_fill) * fill_smoothing;
+
+        const double step = 1.0 + controller.update(filtered_fill
+                                                    - target_fill);
+        const double end  = phase + (period_frame_size * step);
+        const std::size_t consumed = static_cast<std::size_t>(end);
+
+        // the last output may sit just past the last frame consumed and
+        // interpolation reads two frames beyond it
+        if (available < (consumed + 3)) {
+            running = false;
+            underruns.fetch_add(1, std::memory_order_relaxed);
+            return silence(period);
+        }
+
+        // linearize the frames used, in at most two pieces
+        const std::size_t used  = consumed + 3;
+        const std::size_t first = read & (capacity - 1);
+        const std::size_t split = ((first + used) > capacity)
+                                ? (capacity - first)
+                                : used;
+
+        scratch[0] = previous;
+        detail::widen(&frames[first], &scratch[1], split);
+        detail::widen(&frames[0], &scratch[1 + split], used - split);
+
+        std::int16_t samples[period_frame_size];
+        detail::interpolate(scratch,
+                            samples,
+                            period_frame_size,
+                            phase,
+                            step);
+        std::memcpy(period, samples, period_size);
+
+        previous = scratch[consumed];
+        phase    = end - static_cast<double>(consumed);
+        head.store(read + consumed, std::memory_order_release);
+
+        correction_ppm.store(static_cast<float>((step - 1.0) * 1e6),
+                             std::memory_order_relaxed);
+
+        return true;
+    }
+
+    // current rate correction, positive if the producer runs fast, from any
+    // thread
+    float
+    drift_ppm() const noexcept
+    {
+        return correction_ppm.load(std::memory_order_relaxed);
+    }
+
+    // frames queued between producer and consumer
+    std::size_t
+    fill_frame_size() const noexcept
+    {
+        return static_cast<std::size_t>(tail.load(std::memory_order_acquire)
+                                        - head.load(std::memory_order_acquire));
+    }
+
+    // pulls that found the queue empty, re-priming it
+    std::uint64_t
+    underrun_count() const noexcept
+    {
+        return underruns.load(std::memory_order_relaxed);
+    }
+
+    // pushes dropped for lack of room
+    std::uint64_t
+    overflow_count() const noexcept
+    {
+        return overflows.load(std::memory_order_relaxed);
+    }
+
+
+private:
+    // weight of each new fill measurement, about a 64 period average
+    static constexpr double fill_smoothing = 1.0 / 64.0;
+
+    static std::int64_t
+    to_nsec(const clock_type::time_point time) noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            time.time_since_epoch()
+        ).count();
+    }
+
+    // writer side of the timestamp's sequence lock, producer thread only
+    void
+    stamp(const clock_type::time_point captured,
+          const std::uint64_t position,
+          const std::size_t frame_count) noexcept
+    {
+        const std::uint64_t current =
+            stamp_sequence.load(std::memory_order_relaxed);
+        stamp_sequence.store(current + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        stamp_nsec.store(to_nsec(captured), std::memory_order_relaxed);
+        stamp_position.store(position, std::memory_order_relaxed);
+        stamp_frame_count.store(frame_count, std::memory_order_relaxed);
+
+        stamp_sequence.store(current + 2, std::memory_order_release);
+    }
+
+    // producer position at 'now', one push behind: the frames its clock
+    // delivered since the last push are queued by the next one
+    double
+    producer_position(const clock_type::time_point now) const noexcept
+    {
+        std::int64_t nsec;
+        std::uint64_t position;
+        std::size_t frame_count;
+        std::uint64_t before;
+        std::uint64_t after;
+
+        do {
+            before = stamp_sequence.load(std::memory_order_acquire);
+
+            nsec        = stamp_nsec.load(std::memory_order_relaxed);
+            position    = stamp_position.load(std::memory_order_relaxed);
+            frame_count = stamp_frame_count.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = stamp_sequence.load(std::memory_order_relaxed);
+        } while ((before != after) || ((before & 1) != 0)); // mid-push
+
+        double elapsed = static_cast<double>(to_nsec(now) - nsec)
+                       * (sample_rate * 1e-9);
+        elapsed = (elapsed > 0.0) ? elapsed : 0.0;
+        elapsed = (elapsed < frame_count) ? elapsed
+                                          : static_cast<double>(frame_count);
+
+        return static_cast<double>(position - frame_count) + elapsed;
+    }
+
+    bool
+    silence(period_type &period) noexcept
+    {
+        std::memset(period, 0, period_size);
+        correction_ppm.store(0.0f, std::memory_order_relaxed);
+
+        return false;
+    }
+
+    std::atomic<std::uint64_t> head; // frames consumed
+    std::atomic<std::uint64_t> tail; // frames produced
+
+    // last push, odd 'stamp_sequence' while being written
+    std::atomic<std::uint64_t> stamp_sequence;
+    std::atomic<std::int64_t> stamp_nsec;
+    std::atomic<std::uint64_t> stamp_position;
+    std::atomic<std::size_t> stamp_frame_count;
+
+    // consumer thread state
+    const double target_fill;
+    detail::DriftController controller;
+    double phase;                    // fractional frame of 'head', [0, 1)
+    float previous;                  // frame before 'head'
+    double filtered_fill;
+    bool running;
+    float scratch[(2 * period_frame_size) + 4]; // frames consumed, linearized
+
+    std::atomic<float> correction_ppm;
+    std::atomic<std::uint64_t> underruns;
+    std::atomic<std::uint64_t> overflows;
+    std::int16_t frames[capacity];
+}; // class DriftResampler
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_DRIFT_RESAMPLER_HPP
@@ -0,0 +1,329 @@
+#ifndef ALSAPP_DUPLEX_HPP
+#define ALSAPP_DUPLEX_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/alsa_interface.h"      // snd_pcm_*, SND_PCM_*
+#include "alsapp/detail/check_action.hpp"      // alsapp::detail::check_action
+#include "alsapp/detail/device_settings.hpp"   // alsapp::detail::DeviceSettings
+#include "alsapp/detail/pcm_format.hpp"        // alsapp::detail::PcmFormat
+#include "alsapp/detail/software_settings.hpp" // alsapp::detail::SoftwareSettings
+#include "alsapp/detail/stream.hpp"            // alsapp::detail::Stream
+#include <cerrno>                              // EPIPE, ESTRPIPE, EAGAIN
+#include <chrono>                              // std::chrono
+#include <cstddef>                             // std::size_t
+#include <cstdint>                             // std::uint64_t
+#include <stdexcept>                           // std::runtime_error
+#include <thread>                              // std::this_thread
+#include <vector>                              // std::vector
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// Linked capture -> playback loop.  Period and buffer sizes are searched the
+// way demo/latency.c does it: start at the minimum latency and grow until both
+// devices agree on a period time with two periods per buffer, failing if that
+// exceeds the maximum latency.  Loop latency starts at two playback periods
+// and is measured by latency_frame_size().
+class Duplex : private detail::PcmFormat
+{
+private:
+    typedef detail::Stream Stream;
+
+    // frames added per search step if the hardware did not round up for us
+    static const snd_pcm_uframes_t search_step = 4;
+
+    // periods queued on playback before capture starts
+    static const snd_pcm_uframes_t prefill_period_count = 2;
+
+    // poll interval while the system resumes suspended streams, and the
+    // attempts made before restarting them instead (5 seconds)
+    static constexpr std::chrono::milliseconds resume_interval{100};
+    static const unsigned int max_resume_attempts = 50;
+
+
+public:
+    Duplex(const char *const capture_name           = "default",
+           const char *const playback_name          = "default",
+           const snd_pcm_uframes_t min_latency_size = 2 * period_frame_size,
+           const snd_pcm_uframes_t max_latency_size = 32 * period_frame_size)
+        : capture(capture_name,
+                  SND_PCM_STREAM_CAPTURE),
+          playback(playback_name,
+                   SND_PCM_STREAM_PLAYBACK),
+          period_frames(tune(min_latency_size,
+                             max_latency_size)),
+          buffer(period_frames * sizeof(frame_type)),
+          silence(period_frames * sizeof(frame_type), 0),
+          xruns(0)
+    {
+        configure_transfer(capture);
+        configure_transfer(playback);
+
+        detail::check_action("link capture and playback",
+                             snd_pcm_link(capture,
+                                          playback));
+
+        start();
+    }
+
+    // Measured capture -> playback latency: frames captured but not read yet
+    // plus frames queued for playback.  The prefill is reported while the
+    // delays can't be queried (e.g. during an xrun).
+    snd_pcm_uframes_t
+    latency_frame_size() const
+    {
+        snd_pcm_sframes_t capture_delay;
+        snd_pcm_sframes_t playback_delay;
+
+        if (   (snd_pcm_delay(capture,  &capture_delay)  < 0)
+            || (snd_pcm_delay(playback, &playback_delay) < 0)
+            || ((capture_delay + playback_delay) < 0))
+            return prefill_period_count * period_frames;
+
+        return static_cast<snd_pcm_uframes_t>(capture_delay + playback_delay);
+    }
+
+    unsigned int
+    latency_usec() const
+    {
+        return static_cast<unsigned int>(
+            (static_cast<std::uint64_t>(latency_frame_size()) * 1000000)
+            / sample_rate
+        );
+    }
+
+    // negotiated period size, may differ from PcmFormat::period_frame_size
+    snd_pcm_uframes_t
+    tuned_period_frame_size() const
+    {
+        return period_frames;
+    }
+
+    // overruns/underruns recovered from so far
+    std::uint64_t
+    xrun_count() const
+    {
+        return xruns;
+    }
+
+    // Pass one period from capture to playback, 'process' may modify it
+    // in place: bool process(char *period, snd_pcm_uframes_t frame_count).
+    // Returns process' result.  A period pending when playback fails is
+    // written once the streams recover.
+    template<typename Processor>
+    bool
+    transfer(Processor &&process)
+    {
+        int status;
+
+        while ((status = read_period()) < 0)
+            recover(status);
+
+        const bool keep_going = process(buffer.data(),
+                                        period_frames);
+
+        while ((status = write_period(buffer.data())) < 0)
+            recover(status);
+
+        return keep_going;
+    }
+
+    // loop until 'process' returns false
+    template<typename Processor>
+    void
+    run(Processor &&process)
+    {
+        while (transfer(process))
+            ;
+    }
+
+
+private:
+    snd_pcm_uframes_t
+    tune(const snd_pcm_uframes_t min_latency_size,
+         const snd_pcm_uframes_t max_latency_size)
+    {
+        snd_pcm_uframes_t candidate = min_latency_size / prefill_period_count;
+        if (candidate < search_step)
+            candidate = search_step;
+
+        while ((candidate * prefill_period_count) <= max_latency_size) {
+            detail::DeviceSettings capture_settings(capture);
+            detail::DeviceSettings playback_settings(playback);
+
+            apply_candidate(capture_settings,  candidate);
+            apply_candidate(playback_settings, candidate);
+
+            const snd_pcm_uframes_t capture_period =
+                capture_settings.period_frame_size();
+            const snd_pcm_uframes_t playback_period =
+                playback_settings.period_frame_size();
+
+            if (   (capture_settings.period_time()
+                    == playback_settings.period_time())
+                && fits_two_periods(capture_settings,  capture_period)
+                && fits_two_periods(playback_settings, playback_period)) {
+                capture_settings.finalize();
+                playback_settings.finalize();
+                return playback_period;
+            }
+
+            // skip sizes the hardware already rounded past
+            snd_pcm_uframes_t next = candidate + search_step;
+            if (capture_period > next)
+                next = capture_period;
+            if (playback_period > next)
+                next = playback_period;
+            candidate = next;
+        }
+
+        throw std::runtime_error(
+            "failed to find common period size within latency bound"
+        );
+    }
+
+    static void
+    apply_candidate(detail::DeviceSettings &settings,
+                    const snd_pcm_uframes_t candidate)
+    {
+        settings.set_rate_resample(true);
+        detail::PcmFormat::apply_stream_settings(settings);
+        (void) settings.set_buffer_frame_size_near(candidate
+                                                   * prefill_period_count);
+        (void) settings.set_period_frame_size_near(candidate);
+    }
+
+    static bool
+    fits_two_periods(const detail::DeviceSettings &settings,
+                     const snd_pcm_uframes_t period_frame_size)
+    {
+        if ((period_frame_size * prefill_period_count)
+            >= settings.buffer_frame_size())
+            return true;
+
+        if (settings.min_period_count() > prefill_period_count)
+            throw std::runtime_error(
+                "device does not support two periods per buffer"
+            );
+
+        return false;
+    }
+
+    void
+    configure_transfer(Stream &stream)
+    {
+        detail::SoftwareSettings settings(stream);
+
+        // started explicitly (capture start also starts linked playback)
+        settings.set_start_threshold(0x7fffffff);
+        settings.set_avail_min(period_frames);
+        settings.finalize();
+    }
+
+    // queue silence on playback, then start both streams
+    void
+    start()
+    {
+        for (snd_pcm_uframes_t i = 0; i < prefill_period_count; ++i)
+            detail::check_action("prefill speaker",
+                                 write_period(silence.data()));
+
+        detail::check_action("start duplex stream",
+                             snd_pcm_start(capture));
+    }
+
+    // Resume both streams in place after a system suspend, keeping their
+    // queued audio, else restart them after an xrun (or a driver that can't
+    // resume), re-establishing the latency by prefilling playback again.
+    void
+    recover(const int status)
+    {
+        ++xruns;
+
+        if ((status == -ESTRPIPE) && resume(capture) && resume(playback))
+            return;
+
+        (void) snd_pcm_drop(capture);
+        detail::check_action("prepare duplex stream",
+                             snd_pcm_prepare(capture));
+
+        start();
+    }
+
+    // false once 'stream' can't be resumed, waits while the system resumes
+    static bool
+    resume(Stream &stream)
+    {
+        int resumed = snd_pcm_resume(stream);
+
+        for (unsigned int attempt = 1;
+             (resumed == -EAGAIN) && (attempt < max_resume_attempts);
+             ++attempt) {
+            std::this_thread::sleep_for(resume_interval);
+
+            resumed = snd_pcm_resume(stream);
+        }
+
+        return resumed == 0;
+    }
+
+    // 0, or -EPIPE/-ESTRPIPE on xrun
+    int
+    read_period()
+    {
+        return transfer_period(capture,
+                               buffer.data(),
+                               "read from duplex capture");
+    }
+
+    int
+    write_period(char *const period)
+    {
+        return transfer_period(playback,
+                               period,
+                               "write to duplex playback");
+    }
+
+    int
+    transfer_period(Stream &stream,
+                    char *const period,
+                    const char *const action)
+    {
+        const bool is_capture = (&stream == &capture);
+
+        char *cursor = period;
+        snd_pcm_uframes_t frames_remaining = period_frames;
+
+        while (frames_remaining > 0) {
+            const snd_pcm_sframes_t frames_transferred = is_capture
+                ? snd_pcm_readi(stream,  cursor, frames_remaining)
+                : snd_pcm_writei(stream, cursor, frames_remaining);
+
+            if (   (frames_transferred == -EPIPE)
+                || (frames_transferred == -ESTRPIPE))
+                return static_cast<int>(frames_transferred);
+
+            detail::check_action(action,
+                                 static_cast<int>(frames_transferred));
+
+            cursor           += frames_transferred * sizeof(frame_type);
+            frames_remaining -= frames_transferred;
+        }
+
+        return 0;
+    }
+
+    Stream capture;
+    Stream playback;
+    const snd_pcm_uframes_t period_frames;
+    std::vector<char> buffer;        // period in transfer
+    std::vector<char> silence;       // prefill period
+    std::uint64_t xruns;
+}; // class Duplex
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_DUPLEX_HPP
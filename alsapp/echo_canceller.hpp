@@ -0,0 +1,232 @@
+#ifndef ALSAPP_ECHO_CANCELLER_HPP
+#define ALSAPP_ECHO_CANCELLER_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/capture_config.hpp"    // alsapp::detail::is_power_of_two
+#include "alsapp/detail/fft.hpp"        // alsapp::detail::Fft
+#include "alsapp/detail/pcm_format.hpp" // alsapp::detail::PcmFormat
+#include <cstddef>                      // std::size_t
+#include <cstring>                      // std::memcpy, std::memset
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// Acoustic echo canceller: a partitioned-block frequency-domain NLMS filter
+// (overlap-save, gradient-constrained) of 'partition_count' periods, so it
+// models echo paths up to partition_count * 8 ms long at 16 kHz.
+//
+// Each call consumes one microphone period and the playback reference period
+// heard during it and yields the cleaned period.  Processing is block
+// synchronous, so the stage adds no latency beyond the period itself.  The
+// caller aligns the reference (see ReferenceTap).
+//
+// All state lives inside the object: nothing is allocated per period.
+template<std::size_t partition_count = 8>
+class EchoCanceller : private detail::PcmFormat
+{
+    static_assert(partition_count > 0,
+                  "echo canceller needs at least one partition");
+
+private:
+    // Echo Canceller Settings
+    // -------------------------------------------------------------------------
+    // one period per block, transforms span two blocks (overlap-save)
+    static const std::size_t block_size = period_frame_size;
+    static const std::size_t fft_size   = 2 * block_size;
+
+    static_assert(detail::is_power_of_two(block_size),
+                  "echo cancelling needs a power of two period frame size");
+
+    // reference power smoothing (per bin)
+    static constexpr float power_smoothing = 0.9f;
+
+    // keeps the normalization finite in silent bins
+    static constexpr float regularization = 1e-6f;
+
+    typedef float spectrum_type[fft_size];
+
+
+public:
+    using detail::PcmFormat::period_type; // audio units
+
+    explicit EchoCanceller(const float step_size = 0.5f)
+        : step_size(step_size),
+          newest(0)
+    {
+        reset();
+    }
+
+    // forget the learned echo path
+    void
+    reset()
+    {
+        std::memset(reference_time, 0, sizeof(reference_time));
+        std::memset(reference_re,   0, sizeof(reference_re));
+        std::memset(reference_im,   0, sizeof(reference_im));
+        std::memset(weight_re,      0, sizeof(weight_re));
+        std::memset(weight_im,      0, sizeof(weight_im));
+        std::memset(power,          0, sizeof(power));
+    }
+
+    // cancel the echo of 'reference' from 'microphone' into 'output'
+    // ('output' may alias 'microphone')
+    void
+    process(const period_type &microphone,
+            const period_type &reference,
+            period_type &output)
+    {
+        sample_type samples[block_size];
+
+        // 1. spectrum of the newest two reference blocks
+        std::memcpy(samples, reference, period_size);
+        std::memmove(&reference_time[0],
+                     &reference_time[block_size],
+                     sizeof(float) * block_size);
+        to_float(samples, &reference_time[block_size]);
+
+        newest = (newest + partition_count - 1) % partition_count;
+        float *const x_re = reference_re[newest];
+        float *const x_im = reference_im[newest];
+
+        std::memcpy(x_re, reference_time, sizeof(spectrum_type));
+        std::memset(x_im, 0, sizeof(spectrum_type));
+        fft.forward(x_re, x_im);
+
+        // 2. echo estimate: sum over partitions of X * W
+        std::memset(scratch_re, 0, sizeof(scratch_re));
+        std::memset(scratch_im, 0, sizeof(scratch_im));
+
+        for (std::size_t p = 0; p < partition_count; ++p)
+            multiply_accumulate(reference_re[delayed(p)],
+                                reference_im[delayed(p)],
+                                weight_re[p],
+                                weight_im[p]);
+
+        fft.inverse(scratch_re, scratch_im);
+
+        // 3. error = microphone - echo estimate (last block is valid)
+        float error[block_size];
+
+        std::memcpy(samples, microphone, period_size);
+        to_float(samples, error);
+
+        for (std::size_t i = 0; i < block_size; ++i)
+            error[i] -= scratch_re[block_size + i];
+
+        to_samples(error, samples);
+        std::memcpy(output, samples, period_size);
+
+        // 4. normalized error spectrum
+        std::memset(error_re, 0, sizeof(float) * block_size);
+        std::memcpy(&error_re[block_size], error, sizeof(error));
+        std::memset(error_im, 0, sizeof(error_im));
+        fft.forward(error_re, error_im);
+
+        for (std::size_t k = 0; k < fft_size; ++k) {
+            power[k] = (power_smoothing * power[k])
+                     + ((1.0f - power_smoothing)
+                        * ((x_re[k] * x_re[k]) + (x_im[k] * x_im[k])));
+
+            const float gain = step_size
+                             / ((partition_count * power[k]) + regularization);
+
+            error_re[k] *= gain;
+            error_im[k] *= gain;
+        }
+
+        // 5. constrained update: W += FFT(first half of IFFT(conj(X) * E))
+        for (std::size_t p = 0; p < partition_count; ++p)
+            update(reference_re[delayed(p)],
+                   reference_im[delayed(p)],
+                   weight_re[p],
+                   weight_im[p]);
+    }
+
+
+private:
+    // reference spectrum 'p' blocks ago
+    std::size_t
+    delayed(const std::size_t p) const
+    {
+        return (newest + p) % partition_count;
+    }
+
+    static void
+    to_float(const sample_type *const samples,
+             float *const values)
+    {
+        for (std::size_t i = 0; i < block_size; ++i)
+            values[i] = static_cast<float>(samples[i]) * (1.0f / 32768.0f);
+    }
+
+    static void
+    to_samples(const float *const values,
+               sample_type *const samples)
+    {
+        for (std::size_t i = 0; i < block_size; ++i) {
+            float value = values[i] * 32768.0f;
+            value = (value >  32767.0f) ?  32767.0f : value;
+            value = (value < -32768.0f) ? -32768.0f : value;
+            samples[i] = static_cast<sample_type>(value);
+        }
+    }
+
+    // scratch += x * w
+    void
+    multiply_accumulate(const float *const x_re,
+                        const float *const x_im,
+                        const float *const w_re,
+                        const float *const w_im)
+    {
+        for (std::size_t k = 0; k < fft_size; ++k) {
+            scratch_re[k] += (x_re[k] * w_re[k]) - (x_im[k] * w_im[k]);
+            scratch_im[k] += (x_re[k] * w_im[k]) + (x_im[k] * w_re[k]);
+        }
+    }
+
+    void
+    update(const float *const x_re,
+           const float *const x_im,
+           float *const w_re,
+           float *const w_im)
+    {
+        // gradient = conj(x) * normalized error
+        for (std::size_t k = 0; k < fft_size; ++k) {
+            scratch_re[k] = (x_re[k] * error_re[k]) + (x_im[k] * error_im[k]);
+            scratch_im[k] = (x_re[k] * error_im[k]) - (x_im[k] * error_re[k]);
+        }
+
+        // keep the filter causal and one block long
+        fft.inverse(scratch_re, scratch_im);
+        std::memset(&scratch_re[block_size], 0, sizeof(float) * block_size);
+        std::memset(&scratch_im[block_size], 0, sizeof(float) * block_size);
+        fft.forward(scratch_re, scratch_im);
+
+        for (std::size_t k = 0; k < fft_size; ++k) {
+            w_re[k] += scratch_re[k];
+            w_im[k] += scratch_im[k];
+        }
+    }
+
+    const float step_size;
+    std::size_t newest; // index of the newest reference spectrum
+    detail::Fft<fft_size> fft;
+
+    float reference_time[fft_size];
+    spectrum_type reference_re[partition_count];
+    spectrum_type reference_im[partition_count];
+    spectrum_type weight_re[partition_count];
+    spectrum_type weight_im[partition_count];
+    spectrum_type power;
+    spectrum_type error_re;
+    spectrum_type error_im;
+    spectrum_type scratch_re;
+    spectrum_type scratch_im;
+}; // class EchoCanceller
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_ECHO_CANCELLER_HPP
@@ -0,0 +1,61 @@
+#ifndef ALSAPP_ERROR_HPP
+#define ALSAPP_ERROR_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/alsa_interface.h" // snd_strerror
+#include <string>                         // std::string
+#include <system_error>                   // std::error_[category|code|condition]
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// ALSA status codes, stored positive (-status).  Values below
+// SND_ERROR_BEGIN are errno values and compare equal to std::errc, e.g.
+// 'error == std::errc::broken_pipe' for an overrun.
+class AlsaErrorCategory : public std::error_category
+{
+public:
+    const char *
+    name() const noexcept override
+    {
+        return "alsa";
+    }
+
+    std::string
+    message(const int value) const override
+    {
+        return snd_strerror(-value);
+    }
+
+    std::error_condition
+    default_error_condition(const int value) const noexcept override
+    {
+        return (value < SND_ERROR_BEGIN)
+             ? std::error_condition(value, std::generic_category())
+             : std::error_condition(value, *this);
+    }
+}; // class AlsaErrorCategory
+
+inline const std::error_category &
+alsa_category() noexcept
+{
+    static const AlsaErrorCategory category;
+
+    return category;
+}
+
+// error code for an ALSA status, clear if it succeeded (never allocates)
+inline std::error_code
+make_alsa_error(const long status) noexcept
+{
+    return (status < 0)
+         ? std::error_code(static_cast<int>(-status), alsa_category())
+         : std::error_code();
+}
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_ERROR_HPP
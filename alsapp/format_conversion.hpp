@@ -0,0 +1,463 @@
+#ifndef ALSAPP_FORMAT_CONVERSION_HPP
+#define ALSAPP_FORMAT_CONVERSION_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/alsa_interface.h" // snd_pcm_format_t, SND_PCM_FORMAT_*
+#include <cstddef>                        // std::size_t
+#include <cstdint>                        // std::[u]int[8|16|32]_t
+#include <stdexcept>                      // std::invalid_argument
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// Sample format conversion between the card's native capture formats and the
+// S16 / float32 formats used in-process.
+//
+// Float samples are full scale at +/-1.0.  Narrowing conversions round to
+// nearest, half away from zero, and saturate (the positive limit is one LSB
+// below +1.0, NaN becomes 0) and return the number of samples that clipped.
+// Optional TPDF dither of +/-1 target LSB is drawn from a counter-based hash,
+// so no sample depends on the previous one.  Every kernel is a branch-free
+// unit-stride loop that compilers vectorize.
+//
+// Supported formats: S16_LE, S24_LE (24 bits in a 32-bit container),
+// S24_3LE (packed), S32_LE and FLOAT_LE.
+
+// TPDF dither source, one per stream
+class Dither
+{
+public:
+    explicit Dither(const std::uint32_t seed = 0x9e3779b9u)
+        : counter(seed)
+    {}
+
+    // triangular noise in [-1, 1) for sample 'index' of the current block
+    float
+    sample(const std::uint32_t index) const noexcept
+    {
+        const std::uint32_t first  = mix(counter + (2 * index));
+        const std::uint32_t second = mix(counter + (2 * index) + 1);
+
+        // two uniform [0, 1) values, difference is triangular in (-1, 1)
+        // (24-bit values convert through int32, which vectorizes)
+        return static_cast<float>(static_cast<std::int32_t>(first >> 8)
+                                  - static_cast<std::int32_t>(second >> 8))
+             * (1.0f / 16777216.0f);
+    }
+
+    // move past a converted block
+    void
+    advance(const std::size_t sample_count) noexcept
+    {
+        counter += static_cast<std::uint32_t>(2 * sample_count);
+    }
+
+
+private:
+    static std::uint32_t
+    mix(std::uint32_t value) noexcept
+    {
+        value ^= value >> 16;
+        value *= 0x7feb352du;
+        value ^= value >> 15;
+        value *= 0x846ca68bu;
+        value ^= value >> 16;
+        return value;
+    }
+
+    std::uint32_t counter;
+}; // class Dither
+
+
+namespace detail {
+
+// round-to-nearest, saturating float -> integer in [-scale, scale - 1]
+template<bool dithered,
+         typename Integer>
+inline std::size_t
+quantize_block(const float *const input,
+               const std::size_t sample_count,
+               const float scale,
+               const Dither *const dither,
+               Integer *const output)
+{
+    const float high = scale - 1.0f;
+    const float low  = -scale;
+
+    // local copy, so the compiler knows stores to 'output' cannot change it
+    const Dither noise = dithered ? *dither : Dither();
+
+    // 32-bit counter, a 64-bit one keeps the loop from vectorizing
+    std::uint32_t clipped = 0;
+
+    for (std::size_t i = 0; i < sample_count; ++i) {
+        float value = input[i] * scale;
+
+        if (dithered)
+            value += noise.sample(static_cast<std::uint32_t>(i));
+
+        clipped += (value > high) | (value < low);
+
+        // NaN fails both comparisons of the second clamp and becomes 0
+        value = (value > high) ? high : value;
+        value = (value >= low) ? value : ((value < low) ? low : 0.0f);
+
+        // round half away from zero
+        value += (value < 0.0f) ? -0.5f : 0.5f;
+        output[i] = static_cast<Integer>(static_cast<std::int32_t>(value));
+    }
+
+    return clipped;
+}
+
+template<typename Integer>
+inline std::size_t
+quantize(const float *const input,
+         const std::size_t sample_count,
+         const float scale,
+         Dither *const dither,
+         Integer *const output)
+{
+    if (dither == nullptr)
+        return quantize_block<false>(input, sample_count, scale,
+                                     dither, output);
+
+    const std::size_t clipped = quantize_block<true>(input, sample_count,
+                                                     scale, dither, output);
+    dither->advance(sample_count);
+
+    return clipped;
+}
+
+inline std::int32_t
+unpack_s24_3le(const std::uint8_t *const bytes)
+{
+    const std::uint32_t value = static_cast<std::uint32_t>(bytes[0])
+                              | (static_cast<std::uint32_t>(bytes[1]) << 8)
+                              | (static_cast<std::uint32_t>(bytes[2]) << 16);
+
+    // move the sign bit to bit 31, then shift back arithmetically
+    return static_cast<std::int32_t>(value << 8) >> 8;
+}
+
+} // namespace detail
+
+
+// To Float
+// -----------------------------------------------------------------------------
+inline void
+to_float(const std::int16_t *const input,
+         const std::size_t sample_count,
+         float *const output)
+{
+    for (std::size_t i = 0; i < sample_count; ++i)
+        output[i] = static_cast<float>(input[i]) * (1.0f / 32768.0f);
+}
+
+inline void
+to_float(const std::int32_t *const input,
+         const std::size_t sample_count,
+         float *const output)
+{
+    for (std::size_t i = 0; i < sample_count; ++i)
+        output[i] = static_cast<float>(input[i]) * (1.0f / 2147483648.0f);
+}
+
+// S24_LE: sign-extend the low 24 bits of each 32-bit container
+inline void
+s24_to_float(const std::int32_t *const input,
+             const std::size_t sample_count,
+             float *const output)
+{
+    for (std::size_t i = 0; i < sample_count; ++i)
+        output[i] = static_cast<float>(
+                        static_cast<std::int32_t>(
+                            static_cast<std::uint32_t>(input[i]) << 8
+                        ) >> 8
+                    ) * (1.0f / 8388608.0f);
+}
+
+// S24_3LE: three little-endian bytes per sample
+inline void
+s24_3le_to_float(const std::uint8_t *const input,
+                 const std::size_t sample_count,
+                 float *const output)
+{
+    for (std::size_t i = 0; i < sample_count; ++i)
+        output[i] = static_cast<float>(detail::unpack_s24_3le(&input[3 * i]))
+                  * (1.0f / 8388608.0f);
+}
+
+
+// From Float
+// -----------------------------------------------------------------------------
+// each returns the number of clipped samples
+inline std::size_t
+from_float(const float *const input,
+           const std::size_t sample_count,
+           std::int16_t *const output,
+           Dither *const dither = nullptr)
+{
+    return detail::quantize(input, sample_count, 32768.0f, dither, output);
+}
+
+inline std::size_t
+from_float(const float *const input,
+           const std::size_t sample_count,
+           std::int32_t *const output)
+{
+    // float has 24 bits of mantissa, dither at 32 bits would be inaudible
+    std::size_t clipped = 0;
+
+    for (std::size_t i = 0; i < sample_count; ++i) {
+        float value = input[i];
+        value = (value == value) ? value : 0.0f;
+
+        clipped += (value >= 1.0f) | (value < -1.0f);
+
+        double scaled = static_cast<double>(value) * 2147483648.0;
+        scaled = (scaled >  2147483647.0) ?  2147483647.0 : scaled;
+        scaled = (scaled < -2147483648.0) ? -2147483648.0 : scaled;
+        output[i] = static_cast<std::int32_t>(scaled);
+    }
+
+    return clipped;
+}
+
+inline std::size_t
+float_to_s24_3le(const float *const input,
+                 const std::size_t sample_count,
+                 std::uint8_t *const output,
+                 Dither *const dither = nullptr)
+{
+    std::size_t clipped = 0;
+
+    // quantize in blocks through a small stack buffer
+    const std::size_t block_size = 256;
+    std::int32_t block[block_size];
+
+    for (std::size_t start = 0; start < sample_count; start += block_size) {
+        const std::size_t count = (sample_count - start < block_size)
+                                ? (sample_count - start)
+                                : block_size;
+
+        clipped += detail::quantize(&input[start], count, 8388608.0f,
+                                    dither, block);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            const std::uint32_t value = static_cast<std::uint32_t>(block[i]);
+            std::uint8_t *const bytes = &output[3 * (start + i)];
+
+            bytes[0] = static_cast<std::uint8_t>(value);
+            bytes[1] = static_cast<std::uint8_t>(value >> 8);
+            bytes[2] = static_cast<std::uint8_t>(value >> 16);
+        }
+    }
+
+    return clipped;
+}
+
+
+// Integer Narrowing / Widening
+// -----------------------------------------------------------------------------
+// S32 -> S16 without a float round trip, returns clipped count
+inline std::size_t
+narrow(const std::int32_t *const input,
+       const std::size_t sample_count,
+       std::int16_t *const output,
+       Dither *const dither = nullptr)
+{
+    if (dither != nullptr) {
+        std::size_t clipped = 0;
+
+        for (std::size_t i = 0; i < sample_count; ++i) {
+            // dither in units of the 16-bit LSB (65536 source LSBs)
+            const std::int64_t noise = static_cast<std::int64_t>(
+                dither->sample(static_cast<std::uint32_t>(i)) * 65536.0f
+            );
+            const std::int64_t exact = static_cast<std::int64_t>(input[i])
+                                     + noise;
+
+            // round half away from zero, as quantize() does
+            std::int64_t value = (exact + 32768 - (exact < 0)) >> 16;
+
+            clipped += (value > 32767) | (value < -32768);
+
+            value = (value >  32767) ?  32767 : value;
+            value = (value < -32768) ? -32768 : value;
+            output[i] = static_cast<std::int16_t>(value);
+        }
+
+        dither->advance(sample_count);
+        return clipped;
+    }
+
+    std::size_t clipped = 0;
+
+    for (std::size_t i = 0; i < sample_count; ++i) {
+        // Round half away from zero: one less for negatives makes the
+        // arithmetic shift (a floor) stop short of -0.5.  Only rounding at
+        // the very top can exceed the range.
+        const std::int64_t exact = input[i];
+        std::int64_t value = (exact + 32768 - (exact < 0)) >> 16;
+
+        clipped += (value > 32767);
+
+        value = (value > 32767) ? 32767 : value;
+        output[i] = static_cast<std::int16_t>(value);
+    }
+
+    return clipped;
+}
+
+inline void
+widen(const std::int16_t *const input,
+      const std::size_t sample_count,
+      std::int32_t *const output)
+{
+    for (std::size_t i = 0; i < sample_count; ++i)
+        output[i] = static_cast<std::int32_t>(
+            static_cast<std::uint32_t>(static_cast<std::int32_t>(input[i]))
+            << 16
+        );
+}
+
+
+// Runtime Dispatch
+// -----------------------------------------------------------------------------
+// bytes per sample of a supported format
+inline std::size_t
+sample_width(const snd_pcm_format_t format)
+{
+    switch (format) {
+    case SND_PCM_FORMAT_S16_LE:   return 2;
+    case SND_PCM_FORMAT_S24_3LE:  return 3;
+    case SND_PCM_FORMAT_S24_LE:   return 4;
+    case SND_PCM_FORMAT_S32_LE:   return 4;
+    case SND_PCM_FORMAT_FLOAT_LE: return 4;
+    default:
+        throw std::invalid_argument("unsupported sample format");
+    }
+}
+
+// any supported format -> float
+inline void
+convert_to_float(const void *const input,
+                 const snd_pcm_format_t format,
+                 const std::size_t sample_count,
+                 float *const output)
+{
+    switch (format) {
+    case SND_PCM_FORMAT_S16_LE:
+        to_float(static_cast<const std::int16_t *>(input),
+                 sample_count, output);
+        break;
+
+    case SND_PCM_FORMAT_S24_3LE:
+        s24_3le_to_float(static_cast<const std::uint8_t *>(input),
+                         sample_count, output);
+        break;
+
+    case SND_PCM_FORMAT_S24_LE:
+        s24_to_float(static_cast<const std::int32_t *>(input),
+                     sample_count, output);
+        break;
+
+    case SND_PCM_FORMAT_S32_LE:
+        to_float(static_cast<const std::int32_t *>(input),
+                 sample_count, output);
+        break;
+
+    case SND_PCM_FORMAT_FLOAT_LE:
+        for (std::size_t i = 0; i < sample_count; ++i)
+            output[i] = static_cast<const float *>(input)[i];
+        break;
+
+    default:
+        throw std::invalid_argument("unsupported sample format");
+    }
+}
+
+// any supported format -> S16, returns clipped count
+inline std::size_t
+convert_to_s16(const void *const input,
+               const snd_pcm_format_t format,
+               const std::size_t sample_count,
+               std::int16_t *const output,
+               Dither *const dither = nullptr)
+{
+    switch (format) {
+    case SND_PCM_FORMAT_S16_LE:
+        for (std::size_t i = 0; i < sample_count; ++i)
+            output[i] = static_cast<const std::int16_t *>(input)[i];
+        return 0;
+
+    case SND_PCM_FORMAT_S32_LE:
+        return narrow(static_cast<const std::int32_t *>(input),
+                      sample_count, output, dither);
+
+    default:
+        break;
+    }
+
+    // S24 and float go through float in blocks
+    const std::size_t block_size = 256;
+    const std::size_t width = sample_width(format);
+    const std::uint8_t *const bytes = static_cast<const std::uint8_t *>(input);
+
+    float block[block_size];
+    std::size_t clipped = 0;
+
+    for (std::size_t start = 0; start < sample_count; start += block_size) {
+        const std::size_t count = (sample_count - start < block_size)
+                                ? (sample_count - start)
+                                : block_size;
+
+        convert_to_float(&bytes[start * width], format, count, block);
+        clipped += from_float(block, count, &output[start], dither);
+    }
+
+    return clipped;
+}
+
+// float -> any supported format, returns clipped count
+inline std::size_t
+convert_from_float(const float *const input,
+                   const std::size_t sample_count,
+                   const snd_pcm_format_t format,
+                   void *const output,
+                   Dither *const dither = nullptr)
+{
+    switch (format) {
+    case SND_PCM_FORMAT_S16_LE:
+        return from_float(input, sample_count,
+                          static_cast<std::int16_t *>(output), dither);
+
+    case SND_PCM_FORMAT_S24_3LE:
+        return float_to_s24_3le(input, sample_count,
+                                static_cast<std::uint8_t *>(output), dither);
+
+    case SND_PCM_FORMAT_S24_LE:
+        return detail::quantize(input, sample_count, 8388608.0f, dither,
+                                static_cast<std::int32_t *>(output));
+
+    case SND_PCM_FORMAT_S32_LE:
+        return from_float(input, sample_count,
+                          static_cast<std::int32_t *>(output));
+
+    case SND_PCM_FORMAT_FLOAT_LE:
+        for (std::size_t i = 0; i < sample_count; ++i)
+            static_cast<float *>(output)[i] = input[i];
+        return 0;
+
+    default:
+        throw std::invalid_argument("unsupported sample format");
+    }
+}
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_FORMAT_CONVERSION_HPP
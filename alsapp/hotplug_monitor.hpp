@@ -0,0 +1,206 @@
+#ifndef ALSAPP_HOTPLUG_MONITOR_HPP
+#define ALSAPP_HOTPLUG_MONITOR_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/check_action.hpp" // alsapp::detail::check_action
+#include <cerrno>                         // errno, EAGAIN, EWOULDBLOCK, EINTR
+#include <chrono>                         // std::chrono
+#include <cstddef>                        // std::size_t
+#include <cstdlib>                        // std::strtol
+#include <cstring>                        // std::str[n]cmp, std::strlen
+#include <linux/netlink.h>                // sockaddr_nl, NETLINK_KOBJECT_UEVENT
+#include <poll.h>                         // poll, pollfd, POLLIN
+#include <sys/socket.h>                   // socket, bind, recvfrom
+#include <sys/types.h>                    // ssize_t
+#include <unistd.h>                       // close
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+struct HotplugEvent
+{
+    enum class Action
+    {
+        added,  // card registered, its PCMs open once udev made the nodes
+        removed // card gone, open handles return -ENODEV
+    };
+
+    Action action;
+    int card; // sound card index ("hw:<card>")
+}; // struct HotplugEvent
+
+// Watches kernel uevents for sound cards coming and going.  Only the card's
+// control device is reported, so one event is raised per card rather than
+// one per PCM.  The socket is non-blocking; poll descriptor() alongside
+// capture handles or call wait().
+//
+// Events come straight from the kernel, before udev has created the
+// /dev/snd nodes and set their permissions: retry opening an added card's
+// PCMs with a backoff rather than once.  Messages not sent by the kernel
+// (any process can send to the group) are dropped.
+class HotplugMonitor
+{
+public:
+    HotplugMonitor()
+    {
+        socket_fd = socket(AF_NETLINK,
+                           SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                           NETLINK_KOBJECT_UEVENT);
+        detail::check_action("open uevent socket",
+                             (socket_fd < 0) ? -errno : 0);
+
+        sockaddr_nl address = {};
+        address.nl_family = AF_NETLINK;
+        address.nl_groups = 1; // kernel broadcast group
+
+        if (bind(socket_fd,
+                 reinterpret_cast<const sockaddr *>(&address),
+                 sizeof(address)) < 0) {
+            const int status = -errno;
+            (void) close(socket_fd);
+            detail::check_action("bind uevent socket", status);
+        }
+    }
+
+    ~HotplugMonitor()
+    {
+        (void) close(socket_fd);
+    }
+
+    HotplugMonitor(const HotplugMonitor &)            = delete;
+    HotplugMonitor &operator=(const HotplugMonitor &) = delete;
+
+    // for poll(), readable when read() may return an event
+    int
+    descriptor() const
+    {
+        return socket_fd;
+    }
+
+    // take the next sound card event, false when none are pending
+    bool
+    read(HotplugEvent &event)
+    {
+        for (;;) {
+            sockaddr_nl sender = {};
+            socklen_t sender_size = sizeof(sender);
+
+            const ssize_t size = recvfrom(socket_fd,
+                                          message,
+                                          sizeof(message) - 1,
+                                          0,
+                                          reinterpret_cast<sockaddr *>(&sender),
+                                          &sender_size);
+            if (size < 0) {
+                if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+                    return false;
+
+                if (errno == EINTR)
+                    continue;
+
+                detail::check_action("read uevent", -errno);
+            }
+
+            if (sender.nl_pid != 0)
+                continue; // not the kernel
+
+            message[size] = '\0';
+
+            if (parse(static_cast<std::size_t>(size), event))
+                return true;
+        }
+    }
+
+    // block up to 'timeout_msec' (-1 for ever) for a sound card event
+    bool
+    wait(HotplugEvent &event,
+         const int timeout_msec = -1)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        // other subsystems' uevents must not restart the timeout
+        const Clock::time_point deadline = Clock::now()
+                                         + std::chrono::milliseconds(
+                                               (timeout_msec > 0)
+                                               ? timeout_msec
+                                               : 0
+                                           );
+        pollfd readable = { socket_fd, POLLIN, 0 };
+
+        for (;;) {
+            if (read(event))
+                return true;
+
+            int remaining_msec = timeout_msec;
+            if (timeout_msec > 0) {
+                const auto remaining =
+                    std::chrono::ceil<std::chrono::milliseconds>(
+                        deadline - Clock::now()
+                    ).count();
+
+                remaining_msec = (remaining > 0)
+                               ? static_cast<int>(remaining)
+                               : 0;
+            }
+
+            const int ready = poll(&readable, 1, remaining_msec);
+            if (ready == 0)
+                return false;
+
+            if ((ready < 0) && (errno != EINTR))
+                detail::check_action("poll uevent socket", -errno);
+        }
+    }
+
+
+private:
+    // "<action>@<devpath>\0KEY=value\0KEY=value\0..."
+    bool
+    parse(const std::size_t size,
+          HotplugEvent &event) const
+    {
+        const char *action    = nullptr;
+        const char *subsystem = nullptr;
+        const char *devname   = nullptr;
+
+        for (std::size_t offset = 0; offset < size;) {
+            const char *const field = &message[offset];
+
+            if (std::strncmp(field, "ACTION=", 7) == 0)
+                action = field + 7;
+            else if (std::strncmp(field, "SUBSYSTEM=", 10) == 0)
+                subsystem = field + 10;
+            else if (std::strncmp(field, "DEVNAME=", 8) == 0)
+                devname = field + 8;
+
+            offset += std::strlen(field) + 1;
+        }
+
+        if (!action || !subsystem || !devname
+            || (std::strcmp(subsystem, "sound") != 0)
+            || (std::strncmp(devname, "snd/controlC", 12) != 0))
+            return false;
+
+        if (std::strcmp(action, "add") == 0)
+            event.action = HotplugEvent::Action::added;
+        else if (std::strcmp(action, "remove") == 0)
+            event.action = HotplugEvent::Action::removed;
+        else
+            return false;
+
+        char *end;
+        event.card = static_cast<int>(std::strtol(devname + 12, &end, 10));
+
+        return (end != devname + 12) && (*end == '\0');
+    }
+
+    int socket_fd;
+    char message[8192]; // uevents are capped at 2048 bytes of environment
+}; // class HotplugMonitor
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_HOTPLUG_MONITOR_HPP
@@ -0,0 +1,257 @@
+#ifndef ALSAPP_LEVEL_METER_HPP
+#define ALSAPP_LEVEL_METER_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/pcm_format.hpp" // alsapp::detail::PcmFormat
+#include <atomic>                       // std::atomic, std::atomic_thread_fence
+#include <chrono>                       // std::chrono
+#include <cmath>                        // std::log10
+#include <cstddef>                      // std::size_t
+#include <cstdint>                      // std::[u]int[16|32|64]_t
+#include <vector>                       // std::vector
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// levels over the last publish interval, relative to full scale
+struct LevelReading
+{
+    float peak_dbfs;
+    float rms_dbfs;
+    float noise_floor_dbfs; // quietest period over the noise window
+    float dc_offset;        // mean sample, fraction of full scale
+    std::uint64_t clip_count; // samples at full scale, since construction
+    std::uint64_t sequence;   // readings published, 0 if none yet
+}; // struct LevelReading
+
+
+namespace detail {
+
+// sums over a block of S16 samples
+struct LevelSums
+{
+    std::int32_t peak; // largest magnitude
+    std::int64_t sum;
+    std::int64_t square_sum;
+    std::uint32_t clip_count;
+}; // struct LevelSums
+
+// one branch-free unit-stride pass, compilers vectorize it
+inline LevelSums
+measure_level(const std::int16_t *const samples,
+              const std::size_t count) noexcept
+{
+    // -32768 and 32767 both count as clipped
+    static const std::int32_t clip_level = 32767;
+
+    std::int32_t peak        = 0;
+    std::int64_t sum         = 0;
+    std::int64_t square_sum  = 0;
+    std::uint32_t clip_count = 0;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::int32_t sample    = samples[i];
+        const std::int32_t magnitude = (sample < 0) ? -sample : sample;
+
+        peak        = (magnitude > peak) ? magnitude : peak;
+        sum        += sample;
+        square_sum += sample * sample; // at most 2^30
+        clip_count += (magnitude >= clip_level);
+    }
+
+    return LevelSums{ peak, sum, square_sum, clip_count };
+}
+
+} // namespace detail
+
+
+// Incremental level meter for S16 capture, fed every period on the capture
+// thread.  update() is one vectorized pass over the period plus a few
+// scalar operations; logarithms are only taken when a reading is published,
+// once per 'publish_interval'.  Readings are published through a sequence
+// lock, so any thread may poll reading() without blocking the capture
+// thread.
+class LevelMeter
+{
+public:
+    // Level Meter Settings
+    // -------------------------------------------------------------------------
+    // reported for digital silence instead of -infinity
+    static constexpr float silence_dbfs = -120.0f;
+
+    explicit LevelMeter(
+        const unsigned int sample_rate   = detail::PcmFormat::sample_rate,
+        const unsigned int channel_count = detail::PcmFormat::channel_count,
+        const std::chrono::milliseconds publish_interval =
+            std::chrono::milliseconds(250),
+        const std::chrono::milliseconds noise_window =
+            std::chrono::milliseconds(10000)
+    )
+        : interval_size(static_cast<std::uint64_t>(sample_rate)
+                        * channel_count
+                        * publish_interval.count() / 1000),
+          noise_minima((noise_window.count() / publish_interval.count()) + 1,
+                       full_scale_square),
+          noise_index(0),
+          sequence(0)
+    {
+        reset_interval();
+        clip_total = 0;
+
+        published_peak        = silence_dbfs;
+        published_rms         = silence_dbfs;
+        published_noise_floor = silence_dbfs;
+        published_dc_offset   = 0.0f;
+        published_clip_count  = 0;
+    }
+
+    LevelMeter(const LevelMeter &)            = delete;
+    LevelMeter &operator=(const LevelMeter &) = delete;
+
+    // account one period (or any block) of interleaved samples
+    void
+    update(const std::int16_t *const samples,
+           const std::size_t count) noexcept
+    {
+        if (count == 0)
+            return;
+
+        const detail::LevelSums sums = detail::measure_level(samples, count);
+
+        peak        = (sums.peak > peak) ? sums.peak : peak;
+        sum        += sums.sum;
+        square_sum += sums.square_sum;
+        clip_total += sums.clip_count;
+
+        const float mean_square = static_cast<float>(sums.square_sum)
+                                / static_cast<float>(count);
+        quietest = (mean_square < quietest) ? mean_square : quietest;
+
+        sample_count += count;
+        if (sample_count >= interval_size)
+            publish();
+    }
+
+    // account whole periods of the shared capture format
+    void
+    update(const detail::PcmFormat::period_type *const periods,
+           const std::size_t period_count) noexcept
+    {
+        update(reinterpret_cast<const std::int16_t *>(&periods[0][0]),
+               period_count * (sizeof(detail::PcmFormat::period_type)
+                               / sizeof(std::int16_t)));
+    }
+
+    // latest published reading, from any thread
+    LevelReading
+    reading() const noexcept
+    {
+        LevelReading latest;
+        std::uint64_t before;
+        std::uint64_t after;
+
+        do {
+            before = sequence.load(std::memory_order_acquire);
+
+            latest.peak_dbfs = published_peak.load(std::memory_order_relaxed);
+            latest.rms_dbfs  = published_rms.load(std::memory_order_relaxed);
+            latest.noise_floor_dbfs =
+                published_noise_floor.load(std::memory_order_relaxed);
+            latest.dc_offset =
+                published_dc_offset.load(std::memory_order_relaxed);
+            latest.clip_count =
+                published_clip_count.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before != after) || ((before & 1) != 0)); // mid-publish
+
+        latest.sequence = before / 2;
+
+        return latest;
+    }
+
+
+private:
+    static constexpr float full_scale        = 32768.0f;
+    static constexpr float full_scale_square = full_scale * full_scale;
+
+    static float
+    to_dbfs(const float power_ratio) noexcept
+    {
+        const float dbfs = 10.0f * std::log10(power_ratio);
+
+        return (dbfs > silence_dbfs) ? dbfs : silence_dbfs;
+    }
+
+    void
+    reset_interval() noexcept
+    {
+        peak         = 0;
+        sum          = 0;
+        square_sum   = 0;
+        quietest     = full_scale_square;
+        sample_count = 0;
+    }
+
+    // writer side of the sequence lock, capture thread only
+    void
+    publish() noexcept
+    {
+        const float count = static_cast<float>(sample_count);
+        const float peak_ratio = static_cast<float>(peak) / full_scale;
+
+        noise_minima[noise_index] = quietest;
+        noise_index = (noise_index + 1) % noise_minima.size();
+
+        float noise_floor = full_scale_square;
+        for (const float minimum : noise_minima)
+            noise_floor = (minimum < noise_floor) ? minimum : noise_floor;
+
+        const std::uint64_t current = sequence.load(std::memory_order_relaxed);
+        sequence.store(current + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        published_peak.store(to_dbfs(peak_ratio * peak_ratio),
+                             std::memory_order_relaxed);
+        published_rms.store(to_dbfs((static_cast<float>(square_sum) / count)
+                                    / full_scale_square),
+                            std::memory_order_relaxed);
+        published_noise_floor.store(to_dbfs(noise_floor / full_scale_square),
+                                    std::memory_order_relaxed);
+        published_dc_offset.store((static_cast<float>(sum) / count)
+                                  / full_scale,
+                                  std::memory_order_relaxed);
+        published_clip_count.store(clip_total, std::memory_order_relaxed);
+
+        sequence.store(current + 2, std::memory_order_release);
+
+        reset_interval();
+    }
+
+    // capture thread state
+    const std::uint64_t interval_size; // samples per reading
+    std::int32_t peak;
+    std::int64_t sum;
+    std::int64_t square_sum;
+    float quietest; // lowest period mean square this interval
+    std::uint64_t sample_count;
+    std::uint64_t clip_total;
+    std::vector<float> noise_minima; // per interval, over the noise window
+    std::size_t noise_index;
+
+    // published reading, odd 'sequence' while being written
+    std::atomic<std::uint64_t> sequence;
+    std::atomic<float> published_peak;
+    std::atomic<float> published_rms;
+    std::atomic<float> published_noise_floor;
+    std::atomic<float> published_dc_offset;
+    std::atomic<std::uint64_t> published_clip_count;
+}; // class LevelMeter
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_LEVEL_METER_HPP
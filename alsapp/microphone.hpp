@@ -6,8 +6,13 @@
 #include "alsapp/detail/check_action.hpp"    // alsapp::detail::check_action
 #include "alsapp/detail/device.hpp"          // alsapp::detail::Device
 #include "alsapp/detail/device_settings.hpp" // alsapp::detail::DeviceSettings
+#include "alsapp/detail/pcm_format.hpp"      // alsapp::detail::PcmFormat
+#include "alsapp/error.hpp"                  // alsapp::make_alsa_error
+#include "alsapp/period_pool.hpp"            // alsapp::Period[Buffer|Pool]
 #include <cstddef>                           // std::size_t
-#include <cstdint>                           // std::int16_t
+#include <cstdint>                           // std::uint64_t
+#include <cstring>                           // std::memcpy
+#include <system_error>                      // std::error_code
 
 
 
@@ -15,41 +20,35 @@
 // =============================================================================
 namespace alsapp {
 
-class Microphone : private detail::Device
+class Microphone : private detail::Device,
+                   private detail::PcmFormat
 {
 private:
-    // Microphone Settings
-    // -------------------------------------------------------------------------
     // request a capture stream
     static const snd_pcm_stream_t stream_mode = SND_PCM_STREAM_CAPTURE;
 
-    // open stream in synchronous, blocking mode
-    static const int open_mode = 0;
-    
-    // grant access to interleaved channel read (and write)
-    static const snd_pcm_access_t access_mode = SND_PCM_ACCESS_RW_INTERLEAVED;
 
-    // signed, 16-bit, little-endian samples
-    static const snd_pcm_format_t sample_format = SND_PCM_FORMAT_S16_LE;
-    typedef std::int16_t sample_type;
-
-    // one channel (mono), one sample per frame
-    static const unsigned int channel_count = 1;
-    typedef sample_type frame_type[channel_count];
-
-    // sample at 16000 HZ
-    static const unsigned int sample_rate = 16000;
-
-    // 128 frames per period
-    static const snd_pcm_uframes_t period_frame_size = 128;
-
-    // sizeof(period_type)
-    static const std::size_t period_size = sizeof(frame_type)
-                                         * period_frame_size;
+public:
+    using detail::PcmFormat::period_type; // audio units
+    using detail::PcmFormat::sample_rate; // frames per second
+    using detail::PcmFormat::config_type; // every derived size and duration
 
+    // outcome of read_batch()
+    struct Batch
+    {
+        enum class Status
+        {
+            complete,   // every whole period available (up to capacity)
+            short_read, // interrupted, the trailing partial period is carried
+            failed      // see 'error', e.g. std::errc::broken_pipe (overrun)
+        };
 
-public:
-    typedef char period_type[period_size]; // audio units
+        Status status;
+        std::error_code error;
+        std::size_t period_count;    // whole periods written to the buffer
+        snd_pcm_uframes_t frame_count; // frames taken from the device
+        std::uint64_t first_frame;   // stream position of the first period
+    }; // struct Batch
 
     Microphone(const char *const device_name = "default")
         : detail::Device(device_name,
@@ -59,14 +58,36 @@ public:
         detail::DeviceSettings settings(*this);
 
         // apply settings
-        settings.set_access_mode(access_mode);
-        settings.set_sample_format(sample_format);
-        settings.set_channel_count(channel_count);
-        settings.set_sample_rate(sample_rate);
-        settings.set_period_frame_size(period_frame_size);
+        detail::PcmFormat::apply(settings);
         settings.finalize();
     }
 
+    // no-throw open, 'error' is set if the microphone is unusable
+    Microphone(const char *const device_name,
+               std::error_code &error) noexcept
+        : detail::Device(device_name,
+                         stream_mode,
+                         open_mode,
+                         error) // open device
+    {
+        if (error)
+            return;
+
+        detail::DeviceSettings settings(*this, error);
+
+        // apply settings
+        if (!error)
+            detail::PcmFormat::apply(settings, error);
+        if (!error)
+            settings.finalize(error);
+    }
+
+    // Move-only.  The device, its settings and any carried partial period
+    // go with the move; a moved-from Microphone may only be assigned to or
+    // destroyed.
+    Microphone(Microphone &&)            = default;
+    Microphone &operator=(Microphone &&) = default;
+
     // read into a period buffer
     std::size_t
     read(period_type *const buffer,
@@ -100,19 +121,187 @@ public:
         return read(&buffer[0], capacity);
     }
 
+    // read whole periods into a run-time sized buffer
+    std::size_t
+    read(PeriodBuffer &buffer)
+    {
+        return read(reinterpret_cast<period_type *>(buffer.data()),
+                    buffer.size() / period_size);
+    }
+
+    // read whole periods into a pool block
+    std::size_t
+    read(PeriodPool::Block &block)
+    {
+        return read(reinterpret_cast<period_type *>(block.data()),
+                    block.size() / period_size);
+    }
+
+    // no-throw read into a period buffer, returns bytes read
+    //
+    // Overruns (std::errc::broken_pipe) and suspends are reported in 'error'
+    // and can be cleared with recover().
+    std::size_t
+    read(period_type *const buffer,
+         const std::size_t capacity,
+         std::error_code &error) noexcept
+    {
+        const snd_pcm_sframes_t frames_read =
+            snd_pcm_readi(*this,
+                          buffer,
+                          capacity * period_frame_size);
+
+        error = make_alsa_error(frames_read);
+
+        return error ? 0
+                     : (static_cast<std::size_t>(frames_read)
+                        * sizeof(frame_type));
+    }
+
+    std::size_t
+    read(period_type &period,
+         std::error_code &error) noexcept
+    {
+        return read(&period, 1, error);
+    }
+
+    template<std::size_t capacity>
+    std::size_t
+    read(period_type (&buffer)[capacity],
+         std::error_code &error) noexcept
+    {
+        return read(&buffer[0], capacity, error);
+    }
+
+    std::size_t
+    read(PeriodPool::Block &block,
+         std::error_code &error) noexcept
+    {
+        return read(reinterpret_cast<period_type *>(block.data()),
+                    block.size() / period_size,
+                    error);
+    }
+
+    // restart after an overrun or suspend reported by a no-throw read,
+    // clears 'error' on success
+    void
+    recover(std::error_code &error) noexcept
+    {
+        if (error && (error.category() == alsa_category()))
+            error = make_alsa_error(snd_pcm_recover(*this, -error.value(), 1));
+    }
+
+    // Read as many whole periods as the device has ready (at most
+    // 'capacity') with a single snd_pcm_readi, blocking only until the first
+    // one is complete.  A trailing partial period left by an interrupted read
+    // is kept and prepended on the next call, so periods always come out whole
+    // and 'first_frame' counts every frame delivered.  Not to be mixed with
+    // read(), which does not see the carried frames.
+    Batch
+    read_batch(period_type *const buffer,
+               const std::size_t capacity) noexcept
+    {
+        Batch batch = {};
+        batch.first_frame = frame_position;
+
+        if (capacity == 0)
+            return batch;
+
+        snd_pcm_sframes_t available = snd_pcm_avail_update(*this);
+
+        if ((available >= 0)
+            && ((carry_frame_count + available) < period_frame_size)) {
+            // poll() never wakes on a capture stream that isn't running
+            if (snd_pcm_state(*this) == SND_PCM_STATE_PREPARED)
+                (void) snd_pcm_start(*this);
+
+            const int ready = snd_pcm_wait(*this, -1);
+
+            available = (ready < 0) ? ready : snd_pcm_avail_update(*this);
+        }
+
+        if (available < 0)
+            return fail(batch, available);
+
+        std::size_t period_count = (carry_frame_count + available)
+                                 / period_frame_size;
+        period_count = (period_count < capacity) ? period_count : capacity;
+        period_count = (period_count > 0) ? period_count : 1;
+
+        char *const frames = &buffer[0][0];
+        std::memcpy(frames, carry, carry_frame_count * sizeof(frame_type));
+
+        const snd_pcm_sframes_t frames_read =
+            snd_pcm_readi(*this,
+                          frames + (carry_frame_count * sizeof(frame_type)),
+                          (period_count * period_frame_size)
+                          - carry_frame_count);
+
+        if (frames_read < 0)
+            return fail(batch, frames_read);
+
+        const snd_pcm_uframes_t frame_total = carry_frame_count + frames_read;
+
+        batch.period_count = frame_total / period_frame_size;
+        batch.frame_count  = static_cast<snd_pcm_uframes_t>(frames_read);
+        batch.status       = (batch.period_count == period_count)
+                           ? Batch::Status::complete
+                           : Batch::Status::short_read;
+
+        carry_frame_count = frame_total % period_frame_size;
+        std::memcpy(carry,
+                    buffer[batch.period_count],
+                    carry_frame_count * sizeof(frame_type));
+
+        frame_position += batch.period_count * period_frame_size;
+
+        return batch;
+    }
+
+    template<std::size_t capacity>
+    Batch
+    read_batch(period_type (&buffer)[capacity]) noexcept
+    {
+        return read_batch(&buffer[0], capacity);
+    }
+
+    Batch
+    read_batch(PeriodPool::Block &block) noexcept
+    {
+        return read_batch(reinterpret_cast<period_type *>(block.data()),
+                          block.size() / period_size);
+    }
+
     // number of periods required to record specified time of sound
     static constexpr std::size_t
     size_buffer_msec(const std::size_t milliseconds)
     {
-        return ((milliseconds * sample_rate) / (period_frame_size * 1000))
-             + (((milliseconds * sample_rate) % (period_frame_size * 1000)) > 0);
+        return config_type::periods_for_msec(milliseconds);
     }
 
     static constexpr std::size_t
     size_buffer_sec(const std::size_t seconds)
     {
-        return size_buffer_sec(seconds * 1000);
+        return config_type::periods_for_sec(seconds);
     }
+
+
+private:
+    // a failed batch breaks continuity, drop the carried frames
+    Batch &
+    fail(Batch &batch,
+         const snd_pcm_sframes_t status) noexcept
+    {
+        batch.status      = Batch::Status::failed;
+        batch.error       = make_alsa_error(status);
+        carry_frame_count = 0;
+
+        return batch;
+    }
+
+    period_type carry;                       // partial period from last batch
+    snd_pcm_uframes_t carry_frame_count = 0; // frames in 'carry'
+    std::uint64_t frame_position        = 0; // frames delivered by read_batch
 }; // class Microphone
 
 } // namespace alsapp
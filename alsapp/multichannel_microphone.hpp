@@ -0,0 +1,143 @@
+#ifndef ALSAPP_MULTICHANNEL_MICROPHONE_HPP
+#define ALSAPP_MULTICHANNEL_MICROPHONE_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/channels.hpp"               // alsapp::deinterleave
+#include "alsapp/detail/alsa_interface.h"    // snd_pcm_*, SND_PCM_*
+#include "alsapp/detail/check_action.hpp"    // alsapp::detail::check_action
+#include "alsapp/detail/device.hpp"          // alsapp::detail::Device
+#include "alsapp/detail/device_settings.hpp" // alsapp::detail::DeviceSettings
+#include "alsapp/detail/pcm_format.hpp"      // alsapp::detail::PcmFormat
+#include "alsapp/detail/sample_traits.hpp"   // alsapp::detail::SampleTraits
+#include <cstddef>                           // std::size_t
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// Capture from 'channel_count' channels in the card's 'Sample' format
+// (std::int16_t, std::int32_t or float).  Periods can be read interleaved, as
+// the card delivers them, or planar (one buffer per channel).  Planar reads
+// use snd_pcm_readn directly when opened with Access::noninterleaved and
+// deinterleave in-process otherwise.
+template<typename Sample,
+         unsigned int channel_count>
+class MultichannelMicrophone : private detail::Device
+{
+private:
+    // Microphone Settings
+    // -------------------------------------------------------------------------
+    // request a capture stream
+    static const snd_pcm_stream_t stream_mode = SND_PCM_STREAM_CAPTURE;
+
+    static const snd_pcm_format_t sample_format =
+        detail::SampleTraits<Sample>::sample_format;
+
+
+public:
+    enum class Access
+    {
+        interleaved,   // SND_PCM_ACCESS_RW_INTERLEAVED, snd_pcm_readi
+        noninterleaved // SND_PCM_ACCESS_RW_NONINTERLEAVED, snd_pcm_readn
+    };
+
+    typedef Sample sample_type;
+
+    static const unsigned int sample_rate = detail::PcmFormat::sample_rate;
+
+    static const snd_pcm_uframes_t period_frame_size =
+        detail::PcmFormat::period_frame_size;
+
+    // one channel of one period
+    typedef sample_type channel_period_type[period_frame_size];
+
+    // frames as delivered by the card
+    typedef sample_type
+        interleaved_period_type[period_frame_size * channel_count];
+
+    // one buffer per channel
+    typedef channel_period_type planar_period_type[channel_count];
+
+    MultichannelMicrophone(const char *const device_name = "default",
+                           const Access access = Access::interleaved)
+        : detail::Device(device_name,
+                         stream_mode,
+                         detail::PcmFormat::open_mode), // open device
+          access(access)
+    {
+        detail::DeviceSettings settings(*this);
+
+        // apply settings
+        settings.set_access_mode((access == Access::interleaved)
+                                 ? SND_PCM_ACCESS_RW_INTERLEAVED
+                                 : SND_PCM_ACCESS_RW_NONINTERLEAVED);
+        settings.set_sample_format(sample_format);
+        settings.set_channel_count(channel_count);
+        settings.set_sample_rate(sample_rate);
+        settings.set_period_frame_size(period_frame_size);
+        settings.finalize();
+    }
+
+    // read interleaved periods, returns frames read
+    // (requires Access::interleaved)
+    std::size_t
+    read(interleaved_period_type *const buffer,
+         const std::size_t capacity)
+    {
+        const snd_pcm_sframes_t frames_read =
+            snd_pcm_readi(*this,
+                          buffer,
+                          capacity * period_frame_size);
+
+        detail::check_action("read from microphone",
+                             static_cast<int>(frames_read));
+
+        return static_cast<std::size_t>(frames_read);
+    }
+
+    std::size_t
+    read(interleaved_period_type &period)
+    {
+        return read(&period, 1);
+    }
+
+    // read one period into per-channel buffers, returns frames read
+    std::size_t
+    read_planar(planar_period_type &period)
+    {
+        sample_type *channels[channel_count];
+        for (unsigned int channel = 0; channel < channel_count; ++channel)
+            channels[channel] = &period[channel][0];
+
+        if (access == Access::noninterleaved) {
+            const snd_pcm_sframes_t frames_read =
+                snd_pcm_readn(*this,
+                              reinterpret_cast<void **>(channels),
+                              period_frame_size);
+
+            detail::check_action("read from microphone",
+                                 static_cast<int>(frames_read));
+
+            return static_cast<std::size_t>(frames_read);
+        }
+
+        const std::size_t frames_read = read(scratch);
+
+        deinterleave<channel_count>(&scratch[0],
+                                    frames_read,
+                                    channels);
+
+        return frames_read;
+    }
+
+
+private:
+    const Access access;
+    interleaved_period_type scratch; // deinterleave source
+}; // class MultichannelMicrophone
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_MULTICHANNEL_MICROPHONE_HPP
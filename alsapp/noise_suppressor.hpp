@@ -0,0 +1,201 @@
+#ifndef ALSAPP_NOISE_SUPPRESSOR_HPP
+#define ALSAPP_NOISE_SUPPRESSOR_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/capture_config.hpp"    // alsapp::detail::is_power_of_two
+#include "alsapp/detail/fft.hpp"        // alsapp::detail::Fft
+#include "alsapp/detail/pcm_format.hpp" // alsapp::detail::PcmFormat
+#include <cmath>                        // std::cos, std::sqrt
+#include <cstddef>                      // std::size_t
+#include <cstring>                      // std::memcpy, std::memset
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// Streaming noise suppressor: overlap-add STFT (256-point sqrt-Hann frames,
+// one 128-frame period hop) with a decision-directed Wiener gain against a
+// per-bin noise floor that follows minima down quickly and creeps up slowly
+// (and recovers at once from digital silence).
+//
+// Output lags input by exactly one period (128 frames, 8 ms at 16 kHz).  All
+// state is fixed size and lives inside the object: nothing is allocated per
+// period.
+class NoiseSuppressor : private detail::PcmFormat
+{
+private:
+    // Noise Suppressor Settings
+    // -------------------------------------------------------------------------
+    static const std::size_t hop_size = period_frame_size;
+    static const std::size_t fft_size = 2 * hop_size;
+
+    static_assert(detail::is_power_of_two(hop_size),
+                  "noise suppression needs a power of two period frame size");
+
+    // smoothing of the per-bin power the noise floor tracks
+    static constexpr float power_smoothing = 0.7f;
+
+    // per-period growth of the noise floor while above it (~3 dB/s)
+    static constexpr float noise_rise = 1.0055f;
+
+    // weight of the previous frame in the decision-directed SNR estimate
+    static constexpr float snr_smoothing = 0.98f;
+
+    // keeps power ratios finite in silent bins
+    static constexpr float regularization = 1e-10f;
+
+    // lowest noise floor, about the per-bin power of 16-bit quantization
+    static constexpr float min_noise_power = 1e-8f;
+
+    typedef float spectrum_type[fft_size];
+
+
+public:
+    using detail::PcmFormat::period_type; // audio units
+
+    // 'gain_floor' bounds attenuation (0.1 = -20 dB)
+    explicit NoiseSuppressor(const float gain_floor = 0.1f)
+        : gain_floor(gain_floor),
+          primed(false)
+    {
+        const double tau = 6.283185307179586476925286766559;
+
+        // periodic sqrt-Hann: analysis * synthesis windows overlap-add to one
+        for (std::size_t i = 0; i < fft_size; ++i)
+            window[i] = static_cast<float>(
+                std::sqrt(0.5 - (0.5 * std::cos((tau * static_cast<double>(i))
+                                                 / fft_size)))
+            );
+
+        reset();
+    }
+
+    // forget the noise estimate and the pending overlap
+    void
+    reset()
+    {
+        std::memset(input,         0, sizeof(input));
+        std::memset(overlap,       0, sizeof(overlap));
+        std::memset(smoothed,      0, sizeof(smoothed));
+        std::memset(noise,         0, sizeof(noise));
+        std::memset(clean_power,   0, sizeof(clean_power));
+        primed = false;
+    }
+
+    // suppress noise in 'period' (output may alias input), delayed one period
+    void
+    process(const period_type &period,
+            period_type &output)
+    {
+        sample_type samples[hop_size];
+
+        // slide the analysis frame by one hop
+        std::memcpy(&input[0], &input[hop_size], sizeof(float) * hop_size);
+        std::memcpy(samples, period, period_size);
+        for (std::size_t i = 0; i < hop_size; ++i)
+            input[hop_size + i] = static_cast<float>(samples[i])
+                                * (1.0f / 32768.0f);
+
+        for (std::size_t i = 0; i < fft_size; ++i) {
+            frame_re[i] = input[i] * window[i];
+            frame_im[i] = 0.0f;
+        }
+
+        fft.forward(frame_re, frame_im);
+
+        apply_gain();
+
+        fft.inverse(frame_re, frame_im);
+
+        // overlap-add the windowed frame, first half is complete
+        for (std::size_t i = 0; i < hop_size; ++i) {
+            float value = (overlap[i] + (frame_re[i] * window[i])) * 32768.0f;
+            value = (value >  32767.0f) ?  32767.0f : value;
+            value = (value < -32768.0f) ? -32768.0f : value;
+            samples[i] = static_cast<sample_type>(value);
+
+            overlap[i] = frame_re[hop_size + i] * window[hop_size + i];
+        }
+
+        std::memcpy(output, samples, period_size);
+    }
+
+    // in-place pipeline stage
+    void
+    operator()(period_type &period)
+    {
+        process(period, period);
+    }
+
+
+private:
+    void
+    apply_gain()
+    {
+        // a real input has a symmetric spectrum, every bin gets its own gain
+        // rather than mirroring half so that the loops stay branch free
+        for (std::size_t k = 0; k < fft_size; ++k) {
+            const float bin_power = (frame_re[k] * frame_re[k])
+                                  + (frame_im[k] * frame_im[k]);
+
+            smoothed[k] = (power_smoothing * smoothed[k])
+                        + ((1.0f - power_smoothing) * bin_power);
+        }
+
+        if (!primed) {
+            std::memcpy(noise, smoothed, sizeof(noise));
+            primed = true;
+        }
+
+        for (std::size_t k = 0; k < fft_size; ++k) {
+            // Follow minima down at once, rise slowly while above them.  A
+            // floor held at the minimum by digital silence (e.g. a
+            // disconnected device) says nothing about the noise, so the next
+            // louder power is taken outright, as when first primed.
+            const float risen = (noise[k] > min_noise_power)
+                              ? (noise[k] * noise_rise)
+                              : smoothed[k];
+            noise[k] = (smoothed[k] < risen) ? smoothed[k] : risen;
+            noise[k] = (noise[k] > min_noise_power) ? noise[k]
+                                                    : min_noise_power;
+
+            const float inverse_noise = 1.0f / (noise[k] + regularization);
+            const float bin_power = (frame_re[k] * frame_re[k])
+                                  + (frame_im[k] * frame_im[k]);
+
+            // a posteriori and decision-directed a priori SNR
+            const float posterior = bin_power * inverse_noise;
+            const float excess    = (posterior > 1.0f) ? (posterior - 1.0f)
+                                                       : 0.0f;
+            const float prior = (snr_smoothing * clean_power[k] * inverse_noise)
+                              + ((1.0f - snr_smoothing) * excess);
+
+            float gain = prior / (1.0f + prior);
+            gain = (gain < gain_floor) ? gain_floor : gain;
+
+            clean_power[k] = gain * gain * bin_power;
+
+            frame_re[k] *= gain;
+            frame_im[k] *= gain;
+        }
+    }
+
+    const float gain_floor;
+    bool primed;
+    detail::Fft<fft_size> fft;
+
+    spectrum_type window;
+    spectrum_type input;       // last two hops, time domain
+    float overlap[hop_size];   // tail of the previous synthesis frame
+    spectrum_type frame_re;
+    spectrum_type frame_im;
+    spectrum_type smoothed;    // smoothed bin power
+    spectrum_type noise;       // noise floor estimate
+    spectrum_type clean_power; // previous frame's estimated clean power
+}; // class NoiseSuppressor
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_NOISE_SUPPRESSOR_HPP
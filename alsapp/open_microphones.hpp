@@ -0,0 +1,71 @@
+#ifndef ALSAPP_OPEN_MICROPHONES_HPP
+#define ALSAPP_OPEN_MICROPHONES_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/microphone.hpp" // alsapp::Microphone
+#include <cstddef>               // std::size_t
+#include <future>                // std::async, std::future
+#include <string>                // std::string
+#include <system_error>          // std::error_code
+#include <vector>                // std::vector
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// Open and negotiate a Microphone for each of 'device_names' at once, one
+// thread per device, so startup waits for the slowest device rather than for
+// all of them in turn.  Microphones come back in 'device_names' order.  If
+// any device fails, the first failure (in that order) is thrown once every
+// open has finished, and the devices that did open are closed again.
+inline std::vector<Microphone>
+open_microphones(const std::vector<std::string> &device_names)
+{
+    std::vector<std::future<Microphone>> opening;
+    opening.reserve(device_names.size());
+
+    for (const std::string &name : device_names)
+        opening.push_back(std::async(std::launch::async, [&name] {
+            return Microphone(name.c_str());
+        }));
+
+    std::vector<Microphone> microphones;
+    microphones.reserve(device_names.size());
+
+    // an abandoned std::async future waits for its open on destruction
+    for (std::future<Microphone> &microphone : opening)
+        microphones.push_back(microphone.get());
+
+    return microphones;
+}
+
+// Device errors are reported per device instead, errors[i] is set if
+// microphones[i] is unusable.  Still throws if a thread can't be started.
+inline std::vector<Microphone>
+open_microphones(const std::vector<std::string> &device_names,
+                 std::vector<std::error_code> &errors)
+{
+    errors.assign(device_names.size(), std::error_code());
+
+    std::vector<std::future<Microphone>> opening;
+    opening.reserve(device_names.size());
+
+    for (std::size_t i = 0; i < device_names.size(); ++i)
+        opening.push_back(std::async(std::launch::async, [&, i] {
+            return Microphone(device_names[i].c_str(), errors[i]);
+        }));
+
+    std::vector<Microphone> microphones;
+    microphones.reserve(device_names.size());
+
+    for (std::future<Microphone> &microphone : opening)
+        microphones.push_back(microphone.get());
+
+    return microphones;
+}
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_OPEN_MICROPHONES_HPP
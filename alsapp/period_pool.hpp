@@ -0,0 +1,324 @@
+#ifndef ALSAPP_PERIOD_POOL_HPP
+#define ALSAPP_PERIOD_POOL_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/check_action.hpp" // alsapp::detail::check_action
+#include <atomic>                         // std::atomic
+#include <cerrno>                         // errno, ENOMEM, EINVAL
+#include <cstddef>                        // std::size_t
+#include <cstdint>                        // std::uint[32|64]_t
+#include <cstdlib>                        // std::aligned_alloc, std::free
+#include <memory>                         // std::unique_ptr
+#include <sys/mman.h>                     // mmap, munmap, madvise, MAP_*
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// buffers are aligned (and pool blocks padded) to a cache line, which also
+// satisfies every SIMD load up to AVX-512
+static constexpr std::size_t buffer_alignment = 64;
+
+namespace detail {
+
+inline std::size_t
+align_size(const std::size_t size)
+{
+    return (size + (buffer_alignment - 1)) & ~(buffer_alignment - 1);
+}
+
+struct AlignedDeleter
+{
+    void
+    operator()(char *const data) const
+    {
+        std::free(data);
+    }
+}; // struct AlignedDeleter
+
+} // namespace detail
+
+
+// A run-time sized, cache line aligned byte buffer, e.g. for a recording
+// whose length is only known once the device settings are negotiated.
+class PeriodBuffer
+{
+public:
+    explicit PeriodBuffer(const std::size_t size)
+        : data_(static_cast<char *>(
+                    std::aligned_alloc(buffer_alignment,
+                                       detail::align_size(size ? size : 1))
+                )),
+          size_(size)
+    {
+        detail::check_action("allocate period buffer", data_ ? 0 : -ENOMEM);
+    }
+
+    char *
+    data() const
+    {
+        return data_.get();
+    }
+
+    // bytes
+    std::size_t
+    size() const
+    {
+        return size_;
+    }
+
+
+private:
+    std::unique_ptr<char, detail::AlignedDeleter> data_;
+    std::size_t size_;
+}; // class PeriodBuffer
+
+
+// A fixed set of equally sized, cache line aligned blocks carved out of one
+// mapping, handed out and returned without locks or allocation, so capture
+// and network threads can pass audio by block without touching malloc.
+//
+// The free list is a Treiber stack whose head carries a generation tag in
+// its upper 32 bits to defeat ABA.
+class PeriodPool
+{
+private:
+    static constexpr std::uint32_t empty = 0xffffffff; // end of the free list
+
+
+public:
+    enum class Backing
+    {
+        normal,  // regular pages
+        hugepage // MAP_HUGETLB, else transparent huge pages, else regular
+    };
+
+    // Owns one block until destroyed or moved from, empty if the pool was
+    // exhausted.
+    class Block
+    {
+    public:
+        Block()
+            : pool(nullptr),
+              index(empty)
+        {}
+
+        Block(Block &&other) noexcept
+            : pool(other.pool),
+              index(other.index)
+        {
+            other.pool = nullptr;
+        }
+
+        Block &
+        operator=(Block &&other) noexcept
+        {
+            if (this != &other) {
+                reset();
+                pool       = other.pool;
+                index      = other.index;
+                other.pool = nullptr;
+            }
+
+            return *this;
+        }
+
+        Block(const Block &)            = delete;
+        Block &operator=(const Block &) = delete;
+
+        ~Block()
+        {
+            reset();
+        }
+
+        explicit operator bool() const
+        {
+            return pool != nullptr;
+        }
+
+        char *
+        data() const
+        {
+            return pool->block_data(index);
+        }
+
+        // bytes
+        std::size_t
+        size() const
+        {
+            return pool->block_size;
+        }
+
+        // return the block to the pool early
+        void
+        reset()
+        {
+            if (pool != nullptr) {
+                pool->release(index);
+                pool = nullptr;
+            }
+        }
+
+
+    private:
+        friend class PeriodPool;
+
+        Block(PeriodPool *const pool,
+              const std::uint32_t index)
+            : pool(pool),
+              index(index)
+        {}
+
+        PeriodPool *pool;
+        std::uint32_t index;
+    }; // class Block
+
+    PeriodPool(const std::size_t block_size,
+               const std::size_t block_count,
+               const Backing backing = Backing::normal)
+        : block_size(block_size),
+          block_stride(detail::align_size(block_size)),
+          block_count(block_count),
+          mapping_size(block_stride * block_count),
+          links(new std::atomic<std::uint32_t>[block_count])
+    {
+        detail::check_action("size period pool",
+                             ((block_size == 0)
+                              || (block_count == 0)
+                              || (block_count >= empty)) ? -EINVAL : 0);
+
+        map(backing);
+
+        // chain every block into the free list
+        for (std::size_t index = 0; index < block_count; ++index)
+            links[index].store((index + 1 < block_count)
+                               ? static_cast<std::uint32_t>(index + 1)
+                               : empty,
+                               std::memory_order_relaxed);
+
+        head.store(0, std::memory_order_release);
+    }
+
+    // blocks must be returned first
+    ~PeriodPool()
+    {
+        (void) munmap(blocks, mapping_size);
+    }
+
+    PeriodPool(const PeriodPool &)            = delete;
+    PeriodPool &operator=(const PeriodPool &) = delete;
+
+    // take a free block, empty if none are left (lock-free)
+    Block
+    acquire()
+    {
+        std::uint64_t old_head = head.load(std::memory_order_acquire);
+
+        for (;;) {
+            const std::uint32_t index = static_cast<std::uint32_t>(old_head);
+            if (index == empty)
+                return Block();
+
+            const std::uint64_t new_head =
+                next_tag(old_head)
+              | links[index].load(std::memory_order_relaxed);
+
+            if (head.compare_exchange_weak(old_head,
+                                           new_head,
+                                           std::memory_order_acquire,
+                                           std::memory_order_acquire))
+                return Block(this, index);
+        }
+    }
+
+    std::size_t
+    size() const
+    {
+        return block_count;
+    }
+
+
+private:
+    void
+    map(const Backing backing)
+    {
+        void *mapping = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+        if (backing == Backing::hugepage) {
+            // explicit huge pages need the length rounded to the page size
+            const std::size_t huge_page_size = 2 * 1024 * 1024;
+
+            mapping_size = (mapping_size + (huge_page_size - 1))
+                         & ~(huge_page_size - 1);
+            mapping = mmap(nullptr,
+                           mapping_size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                           -1,
+                           0);
+        }
+#endif // ifdef MAP_HUGETLB
+
+        if (mapping == MAP_FAILED) {
+            mapping = mmap(nullptr,
+                           mapping_size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS,
+                           -1,
+                           0);
+
+            detail::check_action("map period pool",
+                                 (mapping == MAP_FAILED) ? -errno : 0);
+
+#ifdef MADV_HUGEPAGE
+            if (backing == Backing::hugepage)
+                (void) madvise(mapping, mapping_size, MADV_HUGEPAGE);
+#endif // ifdef MADV_HUGEPAGE
+        }
+
+        blocks = static_cast<char *>(mapping);
+    }
+
+    char *
+    block_data(const std::uint32_t index) const
+    {
+        return blocks + (index * block_stride);
+    }
+
+    void
+    release(const std::uint32_t index)
+    {
+        std::uint64_t old_head = head.load(std::memory_order_relaxed);
+        std::uint64_t new_head;
+
+        do {
+            links[index].store(static_cast<std::uint32_t>(old_head),
+                               std::memory_order_relaxed);
+            new_head = next_tag(old_head) | index;
+        } while (!head.compare_exchange_weak(old_head,
+                                             new_head,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed));
+    }
+
+    static std::uint64_t
+    next_tag(const std::uint64_t head)
+    {
+        return ((head >> 32) + 1) << 32;
+    }
+
+    const std::size_t block_size;
+    const std::size_t block_stride;
+    const std::size_t block_count;
+    std::size_t mapping_size;
+    char *blocks;
+    std::unique_ptr<std::atomic<std::uint32_t>[]> links; // next free block
+    alignas(buffer_alignment) std::atomic<std::uint64_t> head;
+}; // class PeriodPool
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_PERIOD_POOL_HPP
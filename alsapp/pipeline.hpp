@@ -0,0 +1,223 @@
+#ifndef ALSAPP_PIPELINE_HPP
+#define ALSAPP_PIPELINE_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/pcm_format.hpp" // alsapp::detail::PcmFormat
+#include <chrono>                       // std::chrono::steady_clock
+#include <cstddef>                      // std::size_t
+#include <cstdint>                      // std::uint64_t
+#include <cstring>                      // std::memcpy
+#include <tuple>                        // std::tuple, std::get
+#include <utility>                      // std::index_sequence, std::forward
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// A stage is any object callable as 'void stage(period_type &period)' that
+// processes the period in place (lambdas included).  Stages are held by value;
+// wrap large or shared ones in std::ref.
+typedef detail::PcmFormat::period_type period_type;
+
+
+// Timing Hooks
+// -----------------------------------------------------------------------------
+// called around every stage as hook.enter(index) / hook.leave(index)
+struct NoTiming
+{
+    void enter(std::size_t) noexcept {}
+    void leave(std::size_t) noexcept {}
+}; // struct NoTiming
+
+// accumulates wall time spent in each of 'stage_count' stages
+template<std::size_t stage_count>
+class StageTimer
+{
+public:
+    StageTimer()
+    {
+        reset();
+    }
+
+    void
+    reset() noexcept
+    {
+        for (std::size_t i = 0; i < stage_count; ++i)
+            totals[i] = calls[i] = 0;
+    }
+
+    void
+    enter(std::size_t) noexcept
+    {
+        started = std::chrono::steady_clock::now();
+    }
+
+    void
+    leave(const std::size_t index) noexcept
+    {
+        totals[index] += static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - started
+            ).count()
+        );
+        ++calls[index];
+    }
+
+    std::uint64_t
+    total_nsec(const std::size_t index) const noexcept
+    {
+        return totals[index];
+    }
+
+    std::uint64_t
+    call_count(const std::size_t index) const noexcept
+    {
+        return calls[index];
+    }
+
+    double
+    average_nsec(const std::size_t index) const noexcept
+    {
+        return (calls[index] == 0) ? 0.0
+                                   : (static_cast<double>(totals[index])
+                                      / static_cast<double>(calls[index]));
+    }
+
+
+private:
+    std::chrono::steady_clock::time_point started;
+    std::uint64_t totals[stage_count];
+    std::uint64_t calls[stage_count];
+}; // class StageTimer
+
+
+// Pipeline
+// -----------------------------------------------------------------------------
+// Stages composed at compile time.  Each call runs every stage in order on the
+// same period: no heap allocation and no virtual dispatch.
+template<typename... Stages>
+class Pipeline
+{
+public:
+    static const std::size_t stage_count = sizeof...(Stages);
+
+    typedef StageTimer<stage_count> timer_type;
+
+    explicit Pipeline(Stages... stages)
+        : stages(std::move(stages)...)
+    {}
+
+    void
+    operator()(period_type &period)
+    {
+        NoTiming hook;
+        run(period, hook, std::index_sequence_for<Stages...>());
+    }
+
+    // run with a timing hook (e.g. timer_type)
+    template<typename Hook>
+    void
+    operator()(period_type &period,
+               Hook &hook)
+    {
+        run(period, hook, std::index_sequence_for<Stages...>());
+    }
+
+    // run over 'count' consecutive periods
+    template<typename Hook = NoTiming>
+    void
+    process(period_type *const periods,
+            const std::size_t count,
+            Hook &&hook = Hook())
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            (*this)(periods[i], hook);
+    }
+
+    template<std::size_t index>
+    typename std::tuple_element<index, std::tuple<Stages...>>::type &
+    stage() noexcept
+    {
+        return std::get<index>(stages);
+    }
+
+
+private:
+    template<typename Hook,
+             std::size_t... indices>
+    void
+    run(period_type &period,
+        Hook &hook,
+        std::index_sequence<indices...>)
+    {
+        (run_stage<indices>(period, hook), ...);
+    }
+
+    template<std::size_t index,
+             typename Hook>
+    void
+    run_stage(period_type &period,
+              Hook &hook)
+    {
+        hook.enter(index);
+        std::get<index>(stages)(period);
+        hook.leave(index);
+    }
+
+    std::tuple<Stages...> stages;
+}; // class Pipeline
+
+template<typename... Stages>
+Pipeline<Stages...>
+make_pipeline(Stages... stages)
+{
+    return Pipeline<Stages...>(std::move(stages)...);
+}
+
+
+// Fan-Out
+// -----------------------------------------------------------------------------
+// Hands each branch (a stage or Pipeline) its own copy of the period, leaving
+// the original untouched for the stages that follow.  The copy lives in the
+// stage itself.
+template<typename... Branches>
+class FanOut
+{
+public:
+    explicit FanOut(Branches... branches)
+        : branches(std::move(branches)...)
+    {}
+
+    void
+    operator()(period_type &period)
+    {
+        run(period, std::index_sequence_for<Branches...>());
+    }
+
+
+private:
+    template<std::size_t... indices>
+    void
+    run(const period_type &period,
+        std::index_sequence<indices...>)
+    {
+        ((std::memcpy(copy, period, sizeof(copy)),
+          std::get<indices>(branches)(copy)), ...);
+    }
+
+    std::tuple<Branches...> branches;
+    period_type copy;
+}; // class FanOut
+
+template<typename... Branches>
+FanOut<Branches...>
+fan_out(Branches... branches)
+{
+    return FanOut<Branches...>(std::move(branches)...);
+}
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_PIPELINE_HPP
@@ -0,0 +1,255 @@
+#ifndef ALSAPP_REACTOR_HPP
+#define ALSAPP_REACTOR_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "alsapp/reactor.hpp requires C++20 coroutines (-std=c++20)"
+#endif // if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+
+#include "alsapp/detail/check_action.hpp" // alsapp::detail::check_action
+#include <cerrno>                         // errno, EINTR
+#include <coroutine>                      // std::coroutine_handle
+#include <cstddef>                        // std::size_t
+#include <cstdint>                        // std::uint32_t
+#include <exception>                      // std::exception_ptr, ...
+#include <sys/epoll.h>                    // epoll_*, EPOLL*
+#include <unistd.h>                       // close
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+namespace detail {
+
+// something waiting on descriptors registered with a Reactor
+class ReactorWaiter
+{
+public:
+    // 'descriptor' reported 'events' (poll() flags), return the coroutine to
+    // resume, or a null handle to keep waiting
+    virtual std::coroutine_handle<>
+    ready(int descriptor,
+          short events) = 0;
+
+
+protected:
+    ~ReactorWaiter() = default;
+}; // class ReactorWaiter
+
+// one descriptor of a waiter, owned by the waiter at a stable address
+struct ReactorSource
+{
+    ReactorWaiter *waiter;
+    int descriptor;
+}; // struct ReactorSource
+
+// first exception to escape a DetachedTask on this thread, rethrown by the
+// Reactor running it
+inline thread_local std::exception_ptr unhandled_task_exception;
+
+inline void
+rethrow_unhandled_task_exception()
+{
+    if (unhandled_task_exception) {
+        const std::exception_ptr exception = unhandled_task_exception;
+        unhandled_task_exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+} // namespace detail
+
+
+// A single-threaded epoll loop resuming coroutines whose descriptors became
+// ready.  Each wait is one-shot: a waiter re-arms its descriptors when it
+// suspends again, so an idle stream costs nothing.
+class Reactor
+{
+public:
+    // Reactor Settings
+    // -------------------------------------------------------------------------
+    // events collected per epoll_wait
+    static constexpr std::size_t event_capacity = 64;
+
+    Reactor()
+        : epoll_fd(epoll_create1(EPOLL_CLOEXEC)),
+          source_count(0),
+          pending_count(0),
+          stopped(false)
+    {
+        detail::check_action("create epoll instance",
+                             (epoll_fd < 0) ? -errno : 0);
+    }
+
+    ~Reactor()
+    {
+        (void) close(epoll_fd);
+    }
+
+    Reactor(const Reactor &)            = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    // register a source, disarmed
+    void
+    add(detail::ReactorSource &source)
+    {
+        control("register descriptor", EPOLL_CTL_ADD, source, 0);
+        ++source_count;
+    }
+
+    // wait once for poll() 'events' on a registered source
+    void
+    arm(detail::ReactorSource &source,
+        const short events)
+    {
+        control("arm descriptor", EPOLL_CTL_MOD, source, events);
+    }
+
+    // also drops the source's events still pending in this batch
+    void
+    remove(detail::ReactorSource &source)
+    {
+        (void) epoll_ctl(epoll_fd, EPOLL_CTL_DEL, source.descriptor, nullptr);
+        --source_count;
+
+        for (int i = 0; i < pending_count; ++i)
+            if (pending[i].data.ptr == &source)
+                pending[i].data.ptr = nullptr;
+    }
+
+    // Dispatch one batch of events, returns the number of coroutines resumed.
+    // Each is resumed as soon as its waiter is ready: one may destroy
+    // waiters further along the batch, whose events remove() then drops.  An
+    // exception escaping a DetachedTask is rethrown once the batch is done.
+    std::size_t
+    run_once(const int timeout_msec = -1)
+    {
+        detail::rethrow_unhandled_task_exception();
+
+        pending_count = epoll_wait(epoll_fd,
+                                   pending,
+                                   event_capacity,
+                                   timeout_msec);
+        if (pending_count < 0) {
+            pending_count = 0;
+            detail::check_action("wait for events",
+                                 (errno == EINTR) ? 0 : -errno);
+            return 0;
+        }
+
+        std::size_t resumed = 0;
+
+        for (int i = 0; i < pending_count; ++i) {
+            const auto *const source =
+                static_cast<detail::ReactorSource *>(pending[i].data.ptr);
+            if (source == nullptr)
+                continue; // removed by an earlier coroutine in the batch
+
+            const std::coroutine_handle<> handle =
+                source->waiter->ready(source->descriptor,
+                                      static_cast<short>(pending[i].events));
+            if (handle) {
+                handle.resume();
+                ++resumed;
+            }
+        }
+
+        pending_count = 0;
+
+        detail::rethrow_unhandled_task_exception();
+
+        return resumed;
+    }
+
+    // dispatch until stop() or nothing is registered
+    void
+    run()
+    {
+        stopped = false;
+
+        detail::rethrow_unhandled_task_exception();
+
+        while (!stopped && (source_count > 0))
+            (void) run_once();
+    }
+
+    // make run() return after the current batch (from a coroutine on this
+    // reactor)
+    void
+    stop()
+    {
+        stopped = true;
+    }
+
+
+private:
+    void
+    control(const char *const action,
+            const int operation,
+            detail::ReactorSource &source,
+            const short events)
+    {
+        epoll_event event = {};
+        event.events   = static_cast<std::uint16_t>(events) | EPOLLONESHOT;
+        event.data.ptr = &source;
+
+        detail::check_action(action,
+                             (epoll_ctl(epoll_fd,
+                                        operation,
+                                        source.descriptor,
+                                        &event) < 0) ? -errno : 0);
+    }
+
+    int epoll_fd;
+    std::size_t source_count;
+    epoll_event pending[event_capacity]; // batch being dispatched
+    int pending_count;
+    bool stopped;
+}; // class Reactor
+
+
+// A fire-and-forget coroutine: starts immediately, frees itself when done.
+// Capture sessions are spawned as DetachedTasks and driven by a Reactor.  An
+// exception escaping one (e.g. a device that fails to open) ends it and is
+// rethrown from the Reactor's run() or run_once().
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask
+        get_return_object() noexcept
+        {
+            return DetachedTask();
+        }
+
+        std::suspend_never
+        initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never
+        final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void
+        return_void() noexcept
+        {}
+
+        // the first is kept, later ones while it is pending are dropped
+        void
+        unhandled_exception() noexcept
+        {
+            if (!detail::unhandled_task_exception)
+                detail::unhandled_task_exception = std::current_exception();
+        }
+    }; // struct promise_type
+}; // struct DetachedTask
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_REACTOR_HPP
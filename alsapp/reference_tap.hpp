@@ -0,0 +1,82 @@
+#ifndef ALSAPP_REFERENCE_TAP_HPP
+#define ALSAPP_REFERENCE_TAP_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/pcm_format.hpp" // alsapp::detail::PcmFormat
+#include <atomic>                       // std::atomic
+#include <cstddef>                      // std::size_t
+#include <cstring>                      // std::memcpy, std::memset
+#include <stdexcept>                    // std::invalid_argument
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// Single-producer (playback thread), single-consumer (capture thread) queue of
+// the periods sent to a Speaker, used as the echo reference.  The queue starts
+// 'delay_period_count' periods of silence deep so that each popped period
+// lines up with the microphone period in which it is heard.
+class ReferenceTap : private detail::PcmFormat
+{
+private:
+    // periods held at most (must be a power of two)
+    static const std::size_t capacity = 64;
+
+
+public:
+    using detail::PcmFormat::period_type; // audio units
+
+    explicit ReferenceTap(const std::size_t delay_period_count = 2)
+        : head(0),
+          tail(delay_period_count)
+    {
+        if (delay_period_count >= capacity)
+            throw std::invalid_argument("reference delay exceeds tap capacity");
+
+        std::memset(periods, 0, sizeof(periods));
+    }
+
+    // playback side, drops the period if the capture side stopped popping
+    bool
+    push(const period_type &period) noexcept
+    {
+        const std::size_t write = tail.load(std::memory_order_relaxed);
+
+        if ((write - head.load(std::memory_order_acquire)) == capacity)
+            return false;
+
+        std::memcpy(periods[write & (capacity - 1)], period, period_size);
+        tail.store(write + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // capture side, yields silence if playback has nothing queued
+    bool
+    pop(period_type &period) noexcept
+    {
+        const std::size_t read = head.load(std::memory_order_relaxed);
+
+        if (read == tail.load(std::memory_order_acquire)) {
+            std::memset(period, 0, period_size);
+            return false;
+        }
+
+        std::memcpy(period, periods[read & (capacity - 1)], period_size);
+        head.store(read + 1, std::memory_order_release);
+
+        return true;
+    }
+
+
+private:
+    std::atomic<std::size_t> head;
+    std::atomic<std::size_t> tail;
+    period_type periods[capacity];
+}; // class ReferenceTap
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_REFERENCE_TAP_HPP
@@ -0,0 +1,407 @@
+#ifndef ALSAPP_RESILIENT_MICROPHONE_HPP
+#define ALSAPP_RESILIENT_MICROPHONE_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/alsa_interface.h"    // snd_pcm_*, SND_PCM_*
+#include "alsapp/detail/check_action.hpp"    // alsapp::detail::check_action
+#include "alsapp/detail/device_settings.hpp" // alsapp::detail::DeviceSettings
+#include "alsapp/detail/pcm_format.hpp"      // alsapp::detail::PcmFormat
+#include "alsapp/detail/stream.hpp"          // alsapp::detail::Stream
+#include <atomic>                            // std::atomic_bool
+#include <cerrno>                            // E[PIPE|STRPIPE|AGAIN|INTR|BADFD]
+#include <chrono>                            // std::chrono
+#include <cstddef>                           // std::size_t
+#include <cstdint>                           // std::uint64_t
+#include <cstring>                           // std::memset
+#include <functional>                        // std::function
+#include <memory>                            // std::unique_ptr
+#include <poll.h>                            // poll, pollfd
+#include <stdexcept>                         // std::runtime_error
+#include <string>                            // std::string
+#include <sys/eventfd.h>                     // eventfd
+#include <thread>                            // std::this_thread
+#include <unistd.h>                          // close, read, write
+#include <utility>                           // std::move
+#include <vector>                            // std::vector
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// A Microphone that survives overruns, system suspend and the device going
+// away.  Until stopped, reads deliver the requested periods: while the
+// device is missing, silence is delivered at the real-time rate so a
+// consumer (e.g. an open StreamingRecognize call) keeps flowing, and the
+// device is reopened with the same settings on an exponential backoff.
+// Each interruption is reported to the gap handler once capture resumes.
+//
+// stop() interrupts a blocked read at once: capture stops, the frames still
+// buffered in the device are delivered, and then reads return 0.
+class ResilientMicrophone : private detail::PcmFormat
+{
+private:
+    // Microphone Settings
+    // -------------------------------------------------------------------------
+    // request a capture stream
+    static const snd_pcm_stream_t stream_mode = SND_PCM_STREAM_CAPTURE;
+
+
+public:
+    // Resilience Settings
+    // -------------------------------------------------------------------------
+    // reopen attempts start this far apart and double up to 'max_backoff'
+    static constexpr std::chrono::milliseconds min_backoff{50};
+    static constexpr std::chrono::milliseconds max_backoff{2000};
+
+    // poll interval while the system resumes a suspended stream, and the
+    // attempts made before restarting it instead (5 seconds)
+    static constexpr std::chrono::milliseconds resume_interval{100};
+    static const unsigned int max_resume_attempts = 50;
+
+    using detail::PcmFormat::period_type; // audio units
+
+    typedef std::chrono::steady_clock clock;
+
+    struct Gap
+    {
+        enum class Cause
+        {
+            overrun,   // reader fell behind, captured frames were dropped
+            suspend,   // system suspend, stream resumed or restarted
+            disconnect // device lost and reopened
+        };
+
+        Cause cause;
+        clock::time_point start;
+        clock::time_point end;
+        std::size_t silence_frame_count; // frames of silence read in its place
+    }; // struct Gap
+
+    typedef std::function<void(const Gap &)> GapHandler;
+
+    // throws if 'device_name' can't be opened initially
+    ResilientMicrophone(const char *const device_name = "default",
+                        GapHandler on_gap = GapHandler())
+        : device_name(device_name),
+          on_gap(std::move(on_gap)),
+          retry_requested(false),
+          stopping(false),
+          stop_descriptor(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    {
+        detail::check_action("create stop event",
+                             (stop_descriptor < 0) ? -errno : 0);
+
+        try {
+            open();
+        } catch (...) {
+            (void) close(stop_descriptor);
+            throw;
+        }
+    }
+
+    ~ResilientMicrophone()
+    {
+        (void) close(stop_descriptor);
+    }
+
+    // read into a period buffer, fills 'capacity' periods until stopped,
+    // returns the size read
+    std::size_t
+    read(period_type *const buffer,
+         const std::size_t capacity)
+    {
+        char *frames = &buffer[0][0];
+        snd_pcm_uframes_t frames_left = capacity * period_frame_size;
+
+        while (frames_left > 0) {
+            snd_pcm_uframes_t frame_count;
+
+            if (stream) {
+                const snd_pcm_sframes_t ready = wait_ready();
+                if (ready < 0) {
+                    recover(static_cast<int>(ready));
+                    continue;
+                }
+
+                if (ready == 0)
+                    break; // stopped and drained
+
+                const snd_pcm_sframes_t frames_read = snd_pcm_readi(
+                    *stream,
+                    frames,
+                    (static_cast<snd_pcm_uframes_t>(ready) < frames_left)
+                    ? static_cast<snd_pcm_uframes_t>(ready)
+                    : frames_left
+                );
+                if (frames_read < 0) {
+                    recover(static_cast<int>(frames_read));
+                    continue;
+                }
+
+                frame_count = static_cast<snd_pcm_uframes_t>(frames_read);
+
+            } else if (stopping) {
+                break;
+
+            } else {
+                frame_count = read_silence(frames, frames_left);
+            }
+
+            frames      += frame_count * sizeof(frame_type);
+            frames_left -= frame_count;
+        }
+
+        return (capacity * period_frame_size - frames_left) * sizeof(frame_type);
+    }
+
+    // read into a single period
+    std::size_t
+    read(period_type &period)
+    {
+        return read(&period, 1);
+    }
+
+    // read into a C-style array of periods
+    template<std::size_t capacity>
+    std::size_t
+    read(period_type (&buffer)[capacity])
+    {
+        return read(&buffer[0], capacity);
+    }
+
+    // whether periods currently come from the device
+    bool
+    connected() const
+    {
+        return static_cast<bool>(stream);
+    }
+
+    // skip the backoff and try reopening on the next read, e.g. when a
+    // HotplugMonitor reports a card added (callable from any thread)
+    void
+    retry_now()
+    {
+        retry_requested = true;
+    }
+
+    // stop capturing and wake a blocked read (callable from any thread and
+    // from signal handlers)
+    void
+    stop()
+    {
+        stopping = true;
+
+        const std::uint64_t increment = 1;
+        (void) ::write(stop_descriptor, &increment, sizeof(increment));
+    }
+
+    bool
+    stopped() const
+    {
+        return stopping;
+    }
+
+
+private:
+    void
+    open()
+    {
+        std::unique_ptr<detail::Stream> opened(
+            new detail::Stream(device_name.c_str(), stream_mode, open_mode)
+        );
+
+        detail::DeviceSettings settings(*opened);
+
+        // apply settings
+        detail::PcmFormat::apply(settings);
+        settings.finalize();
+
+        stream = std::move(opened);
+    }
+
+    // Frames ready to read, waiting for a whole period or stop().  Once
+    // stopping, capture is halted and whatever is still buffered is
+    // reported without waiting, down to 0.
+    snd_pcm_sframes_t
+    wait_ready()
+    {
+        if (stopping) {
+            // a capture drain halts the stream but keeps its buffered frames
+            if (snd_pcm_state(*stream) == SND_PCM_STATE_RUNNING)
+                (void) snd_pcm_drain(*stream);
+
+            const snd_pcm_sframes_t available = snd_pcm_avail_update(*stream);
+
+            return (available > 0) ? available : 0;
+        }
+
+        // poll() never wakes on a capture stream that isn't running
+        if (snd_pcm_state(*stream) == SND_PCM_STATE_PREPARED) {
+            const int started = snd_pcm_start(*stream);
+            if (started < 0)
+                return started;
+        }
+
+        for (;;) {
+            const snd_pcm_sframes_t available = snd_pcm_avail_update(*stream);
+            if ((available < 0)
+                || (static_cast<snd_pcm_uframes_t>(available)
+                    >= period_frame_size))
+                return available;
+
+            const int status = wait_readable();
+            if (status < 0)
+                return status;
+
+            if (stopping)
+                return wait_ready();
+        }
+    }
+
+    // poll the device and the stop event
+    int
+    wait_readable()
+    {
+        const int count = snd_pcm_poll_descriptors_count(*stream);
+        if (count <= 0)
+            return (count < 0) ? count : -EBADFD;
+
+        descriptors.resize(static_cast<std::size_t>(count) + 1);
+        (void) snd_pcm_poll_descriptors(*stream,
+                                        descriptors.data(),
+                                        static_cast<unsigned int>(count));
+        descriptors[count] = { stop_descriptor, POLLIN, 0 };
+
+        if (poll(descriptors.data(), descriptors.size(), -1) < 0)
+            return (errno == EINTR) ? 0 : -errno;
+
+        // errors surface from the next snd_pcm_avail_update()
+        unsigned short revents;
+        return snd_pcm_poll_descriptors_revents(*stream,
+                                                descriptors.data(),
+                                                static_cast<unsigned int>(count),
+                                                &revents);
+    }
+
+    void
+    recover(const int status)
+    {
+        if ((status == -EINTR) || (status == -EAGAIN))
+            return;
+
+        gap.start = clock::now();
+        gap.silence_frame_count = 0;
+
+        if (status == -EPIPE) {
+            gap.cause = Gap::Cause::overrun;
+
+            if (snd_pcm_prepare(*stream) < 0)
+                return disconnect();
+
+        } else if (status == -ESTRPIPE) {
+            gap.cause = Gap::Cause::suspend;
+
+            // stop() cuts the wait short
+            int resumed = snd_pcm_resume(*stream);
+            for (unsigned int attempt = 1;
+                 (resumed == -EAGAIN) && !stopping
+                 && (attempt < max_resume_attempts);
+                 ++attempt) {
+                pollfd stop_event = { stop_descriptor, POLLIN, 0 };
+                (void) poll(&stop_event, 1,
+                            static_cast<int>(resume_interval.count()));
+
+                resumed = snd_pcm_resume(*stream);
+            }
+
+            // the driver can't resume in place (or took too long), restart
+            // the stream
+            if ((resumed < 0) && (snd_pcm_prepare(*stream) < 0))
+                return disconnect();
+
+        } else {
+            // -ENODEV, -EBADFD, -EIO, ...
+            return disconnect();
+        }
+
+        report();
+    }
+
+    void
+    disconnect()
+    {
+        stream.reset();
+
+        gap.cause    = Gap::Cause::disconnect;
+        silence_due  = gap.start;
+        next_attempt = gap.start;
+        backoff      = min_backoff;
+    }
+
+    // deliver up to a period of silence at the real-time rate, or nothing
+    // if the device came back
+    snd_pcm_uframes_t
+    read_silence(char *const frames,
+                 const snd_pcm_uframes_t frames_left)
+    {
+        const clock::time_point now = clock::now();
+
+        if ((now >= next_attempt) || retry_requested.exchange(false)) {
+            try {
+                open();
+                report();
+                return 0;
+
+            } catch (const std::runtime_error &) {
+                next_attempt = now + backoff;
+                backoff = (2 * backoff < max_backoff) ? (2 * backoff)
+                                                      : max_backoff;
+            }
+        }
+
+        const snd_pcm_uframes_t frame_count =
+            (frames_left < period_frame_size) ? frames_left : period_frame_size;
+
+        std::memset(frames, 0, frame_count * sizeof(frame_type));
+
+        silence_due += std::chrono::duration_cast<clock::duration>(
+            std::chrono::microseconds(
+                (frame_count * 1000000ULL) / sample_rate
+            )
+        );
+        std::this_thread::sleep_until(silence_due);
+
+        gap.silence_frame_count += frame_count;
+
+        return frame_count;
+    }
+
+    void
+    report()
+    {
+        gap.end = clock::now();
+
+        if (on_gap)
+            on_gap(gap);
+    }
+
+    const std::string device_name;
+    const GapHandler on_gap;
+    std::unique_ptr<detail::Stream> stream; // null while disconnected
+
+    Gap gap;                       // interruption in progress
+    clock::time_point silence_due; // when the next silent frames are due
+    clock::time_point next_attempt;
+    clock::duration backoff;
+    std::atomic_bool retry_requested;
+
+    std::atomic_bool stopping;
+    const int stop_descriptor;       // eventfd, readable once stopping
+    std::vector<pollfd> descriptors; // device and stop event
+}; // class ResilientMicrophone
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_RESILIENT_MICROPHONE_HPP
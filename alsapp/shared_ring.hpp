@@ -0,0 +1,516 @@
+#ifndef ALSAPP_SHARED_RING_HPP
+#define ALSAPP_SHARED_RING_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/check_action.hpp" // alsapp::detail::check_action
+#include "alsapp/detail/pcm_format.hpp"   // alsapp::detail::PcmFormat
+#include <atomic>                         // std::atomic
+#include <cerrno>                         // errno, EAGAIN, EINTR, ...
+#include <climits>                        // INT_MAX
+#include <cstddef>                        // std::size_t
+#include <cstdint>                        // std::uint[32|64]_t
+#include <cstring>                        // std::memset, std::strncpy
+#include <ctime>                          // timespec
+#include <new>                            // placement new
+#include <fcntl.h>                        // fcntl, F_ADD_SEALS, F_SEAL_*
+#include <linux/futex.h>                  // FUTEX_WAIT, FUTEX_WAKE
+#include <sys/mman.h>                     // mmap, munmap, memfd_create
+#include <sys/socket.h>                   // socket, sendmsg, recvmsg, ...
+#include <sys/syscall.h>                  // SYS_futex
+#include <sys/un.h>                       // sockaddr_un
+#include <unistd.h>                       // close, ftruncate, syscall, unlink
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+namespace detail {
+
+static constexpr std::uint64_t shared_ring_magic = 0x676e69727070616cULL;
+
+// start of the shared mapping, followed by the slots
+struct alignas(64) SharedRingHeader
+{
+    std::uint64_t magic;
+    std::uint32_t period_size; // bytes of audio per slot
+    std::uint32_t slot_count;  // power of two
+    std::uint64_t slot_stride; // bytes between slots
+
+    // periods published so far, the next sequence number to be written
+    alignas(64) std::atomic<std::uint64_t> write_sequence;
+
+    // bumped after every publish, readers sleep on it
+    alignas(64) std::atomic<std::uint32_t> futex_word;
+}; // struct SharedRingHeader
+
+// Each slot's 'state' is 2 * sequence + 1 while the period is written and
+// 2 * sequence + 2 once it is published, so a reader can tell whether the
+// period it holds has been overwritten.
+struct alignas(64) SharedRingSlot
+{
+    std::atomic<std::uint64_t> state;
+}; // struct SharedRingSlot
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free
+              && std::atomic<std::uint32_t>::is_always_lock_free,
+              "shared ring needs address-free atomics");
+
+inline long
+futex(std::atomic<std::uint32_t> &word,
+      const int operation,
+      const std::uint32_t value,
+      const timespec *const timeout)
+{
+    return syscall(SYS_futex,
+                   reinterpret_cast<std::uint32_t *>(&word),
+                   operation,
+                   value,
+                   timeout,
+                   nullptr,
+                   0);
+}
+
+inline sockaddr_un
+socket_address(const char *const path)
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+    return address;
+}
+
+inline int
+status_of(const long result)
+{
+    return (result < 0) ? -errno : 0;
+}
+
+} // namespace detail
+
+
+// Capture side of a shared-memory fan-out.  Periods are written in place
+// into a ring in a sealed memfd, which is handed to clients over a Unix
+// socket at 'socket_path'.  The writer never waits for readers: a reader
+// that falls more than a ring behind loses periods and is told so.
+class SharedRingWriter
+{
+public:
+    // Ring Settings
+    // -------------------------------------------------------------------------
+    // 256 Microphone periods, 2 seconds of audio
+    static const std::uint32_t default_slot_count = 256;
+
+    typedef detail::PcmFormat::period_type period_type; // audio units
+
+    // slots hold exactly one period_type, which claim() hands out whole
+    SharedRingWriter(const char *const socket_path,
+                     const std::uint32_t slot_count = default_slot_count)
+        : socket_path(socket_path),
+          sequence(0)
+    {
+        detail::check_action("size shared ring",
+                             ((slot_count == 0)
+                              || ((slot_count & (slot_count - 1)) != 0))
+                             ? -EINVAL : 0);
+
+        const std::uint64_t slot_stride =
+            (sizeof(detail::SharedRingSlot) + sizeof(period_type) + 63)
+            & ~63ULL;
+
+        mapping_size = sizeof(detail::SharedRingHeader)
+                     + (slot_stride * slot_count);
+
+        memory_fd = memfd_create("alsapp-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        detail::check_action("create shared ring", detail::status_of(memory_fd));
+
+        detail::check_action("size shared ring",
+                             detail::status_of(ftruncate(memory_fd,
+                                                         mapping_size)));
+
+        // readers may trust the size for as long as they hold the mapping
+        detail::check_action("seal shared ring",
+                             detail::status_of(
+                                 fcntl(memory_fd,
+                                       F_ADD_SEALS,
+                                       F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL)
+                             ));
+
+        void *const mapping = mmap(nullptr,
+                                   mapping_size,
+                                   PROT_READ | PROT_WRITE,
+                                   MAP_SHARED,
+                                   memory_fd,
+                                   0);
+        detail::check_action("map shared ring",
+                             (mapping == MAP_FAILED) ? -errno : 0);
+
+        header = new (mapping) detail::SharedRingHeader;
+        header->magic       = detail::shared_ring_magic;
+        header->period_size = sizeof(period_type);
+        header->slot_count  = slot_count;
+        header->slot_stride = slot_stride;
+        header->write_sequence.store(0, std::memory_order_relaxed);
+        header->futex_word.store(0, std::memory_order_relaxed);
+
+        listen_on_socket();
+    }
+
+    ~SharedRingWriter()
+    {
+        (void) close(listen_fd);
+        (void) unlink(socket_path);
+        (void) munmap(header, mapping_size);
+        (void) close(memory_fd);
+    }
+
+    SharedRingWriter(const SharedRingWriter &)            = delete;
+    SharedRingWriter &operator=(const SharedRingWriter &) = delete;
+
+    // listening socket, readable when a client is waiting for accept_clients()
+    int
+    descriptor() const
+    {
+        return listen_fd;
+    }
+
+    // hand the ring to every client waiting to connect (never blocks)
+    void
+    accept_clients()
+    {
+        for (;;) {
+            const int client_fd = accept4(listen_fd,
+                                          nullptr,
+                                          nullptr,
+                                          SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (client_fd < 0) {
+                if ((errno == EAGAIN) || (errno == EWOULDBLOCK)
+                    || (errno == EINTR) || (errno == ECONNABORTED))
+                    return;
+
+                detail::check_action("accept ring client", -errno);
+            }
+
+            // the client keeps its own mapping, nothing more to say to it
+            (void) send_memory_fd(client_fd);
+            (void) close(client_fd);
+        }
+    }
+
+    // slot for the next period, e.g. to read the Microphone straight into
+    period_type &
+    claim()
+    {
+        slot(sequence).state.store((2 * sequence) + 1,
+                                   std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        return *reinterpret_cast<period_type *>(slot_data(sequence));
+    }
+
+    // make the claimed period visible and wake waiting readers
+    void
+    publish()
+    {
+        slot(sequence).state.store((2 * sequence) + 2,
+                                   std::memory_order_release);
+
+        header->write_sequence.store(++sequence, std::memory_order_release);
+
+        header->futex_word.fetch_add(1, std::memory_order_release);
+        (void) detail::futex(header->futex_word, FUTEX_WAKE, INT_MAX, nullptr);
+    }
+
+    // periods published so far
+    std::uint64_t
+    published_count() const
+    {
+        return sequence;
+    }
+
+
+private:
+    void
+    listen_on_socket()
+    {
+        listen_fd = socket(AF_UNIX,
+                           SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK,
+                           0);
+        detail::check_action("open ring socket", detail::status_of(listen_fd));
+
+        const sockaddr_un address = detail::socket_address(socket_path);
+
+        (void) unlink(socket_path); // left behind by a previous daemon
+
+        detail::check_action(
+            "bind ring socket",
+            detail::status_of(bind(listen_fd,
+                                   reinterpret_cast<const sockaddr *>(&address),
+                                   sizeof(address)))
+        );
+
+        detail::check_action("listen on ring socket",
+                             detail::status_of(listen(listen_fd, 16)));
+    }
+
+    bool
+    send_memory_fd(const int client_fd)
+    {
+        char byte = 0;
+        iovec payload = { &byte, 1 };
+
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+        msghdr message = {};
+        message.msg_iov        = &payload;
+        message.msg_iovlen     = 1;
+        message.msg_control    = control;
+        message.msg_controllen = sizeof(control);
+
+        cmsghdr *const rights = CMSG_FIRSTHDR(&message);
+        rights->cmsg_level = SOL_SOCKET;
+        rights->cmsg_type  = SCM_RIGHTS;
+        rights->cmsg_len   = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(rights), &memory_fd, sizeof(int));
+
+        return sendmsg(client_fd, &message, MSG_NOSIGNAL) == 1;
+    }
+
+    detail::SharedRingSlot &
+    slot(const std::uint64_t sequence) const
+    {
+        return *reinterpret_cast<detail::SharedRingSlot *>(
+            reinterpret_cast<char *>(header + 1)
+          + ((sequence & (header->slot_count - 1)) * header->slot_stride)
+        );
+    }
+
+    char *
+    slot_data(const std::uint64_t sequence) const
+    {
+        return reinterpret_cast<char *>(&slot(sequence) + 1);
+    }
+
+    const char *const socket_path;
+    int memory_fd;
+    int listen_fd;
+    std::size_t mapping_size;
+    detail::SharedRingHeader *header;
+    std::uint64_t sequence; // being written
+}; // class SharedRingWriter
+
+
+// Consumer side: maps the ring read-only and follows it at its own cursor.
+// Periods are not copied; a Period points into the ring and stays intact
+// only while the writer is less than a ring ahead, which valid() checks.
+class SharedRingReader
+{
+public:
+    struct Period
+    {
+        const char *data;
+        std::size_t size;
+        std::uint64_t sequence; // periods since the writer started
+        std::uint64_t skipped;  // periods lost just before this one
+    }; // struct Period
+
+    // attach to the writer at 'socket_path', starting at the newest period
+    explicit SharedRingReader(const char *const socket_path)
+        : lost(0)
+    {
+        const int memory_fd = receive_memory_fd(socket_path);
+
+        mapping_size = lseek(memory_fd, 0, SEEK_END);
+
+        void *const mapping = mmap(nullptr,
+                                   mapping_size,
+                                   PROT_READ,
+                                   MAP_SHARED,
+                                   memory_fd,
+                                   0);
+        const int status = (mapping == MAP_FAILED) ? -errno : 0;
+        (void) close(memory_fd);
+        detail::check_action("map shared ring", status);
+
+        header = static_cast<const detail::SharedRingHeader *>(mapping);
+
+        if (header->magic != detail::shared_ring_magic) {
+            (void) munmap(const_cast<detail::SharedRingHeader *>(header),
+                          mapping_size);
+            detail::check_action("attach to shared ring", -EPROTO);
+        }
+
+        cursor = header->write_sequence.load(std::memory_order_acquire);
+    }
+
+    ~SharedRingReader()
+    {
+        (void) munmap(const_cast<detail::SharedRingHeader *>(header),
+                      mapping_size);
+    }
+
+    SharedRingReader(const SharedRingReader &)            = delete;
+    SharedRingReader &operator=(const SharedRingReader &) = delete;
+
+    // take the next period, waiting up to 'timeout_msec' (-1 for ever),
+    // false on timeout
+    bool
+    read(Period &period,
+         const int timeout_msec = -1)
+    {
+        for (;;) {
+            const std::uint32_t word =
+                header->futex_word.load(std::memory_order_acquire);
+
+            if (try_read(period))
+                return true;
+
+            timespec timeout = { timeout_msec / 1000,
+                                 (timeout_msec % 1000) * 1000000L };
+
+            const long woken =
+                detail::futex(const_cast<std::atomic<std::uint32_t> &>(
+                                  header->futex_word
+                              ),
+                              FUTEX_WAIT,
+                              word,
+                              (timeout_msec < 0) ? nullptr : &timeout);
+
+            if ((woken < 0) && (errno == ETIMEDOUT))
+                return try_read(period);
+        }
+    }
+
+    // take the next period if one is published
+    bool
+    try_read(Period &period)
+    {
+        const std::uint64_t written =
+            header->write_sequence.load(std::memory_order_acquire);
+
+        if (cursor == written)
+            return false;
+
+        std::uint64_t skipped = 0;
+
+        // fell behind: resume half a ring back for headroom
+        if (written - cursor > header->slot_count - 1) {
+            const std::uint64_t resume = written - (header->slot_count / 2);
+
+            skipped = resume - cursor;
+            cursor  = resume;
+        }
+
+        // overwritten since checking, try again from further ahead
+        if (slot(cursor).state.load(std::memory_order_acquire)
+            != (2 * cursor) + 2) {
+            ++cursor;
+            lost += skipped + 1;
+            return try_read(period);
+        }
+
+        period.data     = slot_data(cursor);
+        period.size     = header->period_size;
+        period.sequence = cursor;
+        period.skipped  = skipped;
+
+        lost += skipped;
+        ++cursor;
+
+        return true;
+    }
+
+    // whether 'period' is still intact, check after using its data
+    bool
+    valid(const Period &period) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        return slot(period.sequence).state.load(std::memory_order_relaxed)
+            == (2 * period.sequence) + 2;
+    }
+
+    // periods published but not yet read
+    std::uint64_t
+    backlog() const
+    {
+        return header->write_sequence.load(std::memory_order_acquire) - cursor;
+    }
+
+    // periods lost to falling behind
+    std::uint64_t
+    lost_count() const
+    {
+        return lost;
+    }
+
+
+private:
+    static int
+    receive_memory_fd(const char *const socket_path)
+    {
+        const int socket_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        detail::check_action("open ring socket", detail::status_of(socket_fd));
+
+        const sockaddr_un address = detail::socket_address(socket_path);
+
+        char byte;
+        iovec payload = { &byte, 1 };
+
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+        msghdr message = {};
+        message.msg_iov        = &payload;
+        message.msg_iovlen     = 1;
+        message.msg_control    = control;
+        message.msg_controllen = sizeof(control);
+
+        int status = detail::status_of(
+            connect(socket_fd,
+                    reinterpret_cast<const sockaddr *>(&address),
+                    sizeof(address))
+        );
+        if (status == 0)
+            status = detail::status_of(recvmsg(socket_fd,
+                                               &message,
+                                               MSG_CMSG_CLOEXEC));
+        (void) close(socket_fd);
+        detail::check_action("receive shared ring", status);
+
+        const cmsghdr *const rights = CMSG_FIRSTHDR(&message);
+        detail::check_action("receive shared ring",
+                             ((rights == nullptr)
+                              || (rights->cmsg_type != SCM_RIGHTS))
+                             ? -EPROTO : 0);
+
+        int memory_fd;
+        std::memcpy(&memory_fd, CMSG_DATA(rights), sizeof(int));
+
+        return memory_fd;
+    }
+
+    const detail::SharedRingSlot &
+    slot(const std::uint64_t sequence) const
+    {
+        return *reinterpret_cast<const detail::SharedRingSlot *>(
+            reinterpret_cast<const char *>(header + 1)
+          + ((sequence & (header->slot_count - 1)) * header->slot_stride)
+        );
+    }
+
+    const char *
+    slot_data(const std::uint64_t sequence) const
+    {
+        return reinterpret_cast<const char *>(&slot(sequence) + 1);
+    }
+
+    std::size_t mapping_size;
+    const detail::SharedRingHeader *header;
+    std::uint64_t cursor; // next sequence to read
+    std::uint64_t lost;
+}; // class SharedRingReader
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_SHARED_RING_HPP
@@ -0,0 +1,110 @@
+#ifndef ALSAPP_SPEAKER_HPP
+#define ALSAPP_SPEAKER_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/alsa_interface.h"    // snd_pcm_*, SND_PCM_*
+#include "alsapp/detail/check_action.hpp"    // alsapp::detail::check_action
+#include "alsapp/detail/device.hpp"          // alsapp::detail::Device
+#include "alsapp/detail/device_settings.hpp" // alsapp::detail::DeviceSettings
+#include "alsapp/detail/pcm_format.hpp"      // alsapp::detail::PcmFormat
+#include "alsapp/reference_tap.hpp"          // alsapp::ReferenceTap
+#include <cstddef>                           // std::size_t
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+class Speaker : private detail::Device,
+                private detail::PcmFormat
+{
+private:
+    // request a playback stream
+    static const snd_pcm_stream_t stream_mode = SND_PCM_STREAM_PLAYBACK;
+
+
+public:
+    using detail::PcmFormat::period_type; // audio units
+
+    Speaker(const char *const device_name = "default")
+        : detail::Device(device_name,
+                         stream_mode,
+                         open_mode), // open device
+          tap(nullptr)
+    {
+        detail::DeviceSettings settings(*this);
+
+        // apply settings
+        detail::PcmFormat::apply(settings);
+        settings.finalize();
+    }
+
+    // write from a period buffer, returns bytes written
+    std::size_t
+    write(const period_type *const buffer,
+          std::size_t capacity)
+    {
+        const char *cursor = &buffer[0][0];
+        snd_pcm_uframes_t frames_remaining = capacity * period_frame_size;
+
+        // blocking writes may still return early (signal), finish the buffer
+        while (frames_remaining > 0) {
+            const snd_pcm_sframes_t frames_written = snd_pcm_writei(
+                *this,
+                cursor,
+                frames_remaining
+            );
+
+            detail::check_action("write to speaker",
+                                 static_cast<int>(frames_written));
+
+            cursor           += frames_written * sizeof(frame_type);
+            frames_remaining -= frames_written;
+        }
+
+        if (tap != nullptr)
+            for (std::size_t i = 0; i < capacity; ++i)
+                (void) tap->push(buffer[i]);
+
+        return capacity * period_size;
+    }
+
+    // write from a single period
+    std::size_t
+    write(const period_type &period)
+    {
+        return write(&period, 1);
+    }
+
+    // write from a C-style array of periods
+    template<std::size_t capacity>
+    std::size_t
+    write(const period_type (&buffer)[capacity])
+    {
+        return write(&buffer[0], capacity);
+    }
+
+    // mirror every written period into 'reference' (echo cancellation)
+    void
+    attach(ReferenceTap &reference)
+    {
+        tap = &reference;
+    }
+
+    // block until all queued periods have been played
+    void
+    drain()
+    {
+        detail::check_action("drain speaker",
+                             snd_pcm_drain(*this));
+    }
+
+
+private:
+    ReferenceTap *tap;
+}; // class Speaker
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_SPEAKER_HPP
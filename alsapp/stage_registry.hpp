@@ -0,0 +1,205 @@
+#ifndef ALSAPP_STAGE_REGISTRY_HPP
+#define ALSAPP_STAGE_REGISTRY_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/noise_suppressor.hpp" // alsapp::NoiseSuppressor
+#include "alsapp/pipeline.hpp"         // alsapp::period_type
+#include "alsapp/stages.hpp"           // alsapp::[Gain|VoiceActivity]
+#include <cmath>                       // std::isfinite
+#include <cstddef>                     // std::size_t
+#include <cstdlib>                     // std::strtof
+#include <functional>                  // std::function
+#include <map>                         // std::map
+#include <memory>                      // std::unique_ptr
+#include <stdexcept>                   // std::invalid_argument
+#include <string>                      // std::string
+#include <utility>                     // std::move
+#include <vector>                      // std::vector
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// Runtime Stages
+// -----------------------------------------------------------------------------
+// For pipelines assembled from configuration.  Costs one virtual call per
+// stage per period; prefer Pipeline when the chain is known at compile time.
+class DynamicStage
+{
+public:
+    virtual ~DynamicStage() {}
+
+    virtual void process(period_type &period) = 0;
+}; // class DynamicStage
+
+// adapts any compile-time stage
+template<typename Stage>
+class DynamicStageAdapter : public DynamicStage
+{
+public:
+    explicit DynamicStageAdapter(Stage stage)
+        : stage(std::move(stage))
+    {}
+
+    void
+    process(period_type &period) override
+    {
+        stage(period);
+    }
+
+
+private:
+    Stage stage;
+}; // class DynamicStageAdapter
+
+// stages in insertion order, built once, then run allocation free
+class DynamicPipeline
+{
+public:
+    void
+    append(std::unique_ptr<DynamicStage> stage)
+    {
+        stages.push_back(std::move(stage));
+    }
+
+    std::size_t
+    stage_count() const noexcept
+    {
+        return stages.size();
+    }
+
+    void
+    operator()(period_type &period)
+    {
+        for (const std::unique_ptr<DynamicStage> &stage : stages)
+            stage->process(period);
+    }
+
+    // run with a timing hook, see pipeline.hpp
+    template<typename Hook>
+    void
+    operator()(period_type &period,
+               Hook &hook)
+    {
+        for (std::size_t i = 0; i < stages.size(); ++i) {
+            hook.enter(i);
+            stages[i]->process(period);
+            hook.leave(i);
+        }
+    }
+
+
+private:
+    std::vector<std::unique_ptr<DynamicStage>> stages;
+}; // class DynamicPipeline
+
+
+// Stage Registry
+// -----------------------------------------------------------------------------
+// Maps stage names to factories taking a single argument string, e.g.
+//
+//     registry.build({ "gain:2.0", "noise_suppression", "vad:12" })
+//
+// Malformed arguments ("gain:abc") throw std::invalid_argument.
+class StageRegistry
+{
+public:
+    typedef std::function<std::unique_ptr<DynamicStage>(const std::string &)>
+        factory_type;
+
+    // registry preloaded with the stages alsapp provides
+    StageRegistry()
+    {
+        add("gain", [](const std::string &argument) {
+            return adapt(Gain(parse_argument("gain", argument, 1.0f)));
+        });
+
+        add("noise_suppression", [](const std::string &argument) {
+            return adapt(NoiseSuppressor(
+                parse_argument("noise_suppression", argument, 0.1f)
+            ));
+        });
+
+        // gated, nothing downstream of a dynamic pipeline can ask it
+        add("vad", [](const std::string &argument) {
+            return adapt(VoiceActivity(parse_argument("vad", argument, 9.0f),
+                                       25,
+                                       true));
+        });
+    }
+
+    void
+    add(const std::string &name,
+        factory_type factory)
+    {
+        factories[name] = std::move(factory);
+    }
+
+    // build one stage from "name" or "name:argument"
+    std::unique_ptr<DynamicStage>
+    create(const std::string &specification) const
+    {
+        const std::size_t colon = specification.find(':');
+        const std::string name  = specification.substr(0, colon);
+        const std::string argument = (colon == std::string::npos)
+                                   ? std::string()
+                                   : specification.substr(colon + 1);
+
+        const auto factory = factories.find(name);
+        if (factory == factories.end())
+            throw std::invalid_argument("unknown pipeline stage: " + name);
+
+        return factory->second(argument);
+    }
+
+    DynamicPipeline
+    build(const std::vector<std::string> &specifications) const
+    {
+        DynamicPipeline pipeline;
+
+        for (const std::string &specification : specifications)
+            pipeline.append(create(specification));
+
+        return pipeline;
+    }
+
+    template<typename Stage>
+    static std::unique_ptr<DynamicStage>
+    adapt(Stage stage)
+    {
+        return std::unique_ptr<DynamicStage>(
+            new DynamicStageAdapter<Stage>(std::move(stage))
+        );
+    }
+
+
+private:
+    // a whole, finite number, 'fallback' if empty
+    static float
+    parse_argument(const char *const stage,
+                   const std::string &argument,
+                   const float fallback)
+    {
+        if (argument.empty())
+            return fallback;
+
+        char *end;
+        const float value = std::strtof(argument.c_str(), &end);
+
+        if ((end == argument.c_str()) || (*end != '\0')
+            || !std::isfinite(value))
+            throw std::invalid_argument("malformed argument for pipeline "
+                                        "stage " + std::string(stage) + ": "
+                                        + argument);
+
+        return value;
+    }
+
+    std::map<std::string, factory_type> factories;
+}; // class StageRegistry
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_STAGE_REGISTRY_HPP
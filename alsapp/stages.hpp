@@ -0,0 +1,183 @@
+#ifndef ALSAPP_STAGES_HPP
+#define ALSAPP_STAGES_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/pcm_format.hpp" // alsapp::detail::PcmFormat
+#include "alsapp/echo_canceller.hpp"    // alsapp::EchoCanceller
+#include "alsapp/level_meter.hpp"       // alsapp::detail::measure_level
+#include "alsapp/noise_suppressor.hpp"  // alsapp::NoiseSuppressor
+#include "alsapp/pipeline.hpp"          // alsapp::period_type
+#include "alsapp/reference_tap.hpp"     // alsapp::ReferenceTap
+#include <cmath>                        // std::pow
+#include <cstddef>                      // std::size_t
+#include <cstdint>                      // std::uint64_t
+#include <cstring>                      // std::memcpy, std::memset
+#include <ostream>                      // std::ostream
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// scale every sample, saturating at full scale
+class Gain
+{
+public:
+    explicit Gain(const float factor)
+        : factor(factor)
+    {}
+
+    void
+    operator()(period_type &period) const
+    {
+        detail::PcmFormat::sample_type
+            samples[detail::PcmFormat::period_frame_size];
+
+        std::memcpy(samples, period, sizeof(samples));
+
+        for (std::size_t i = 0; i < detail::PcmFormat::period_frame_size; ++i) {
+            float value = static_cast<float>(samples[i]) * factor;
+            value = (value >  32767.0f) ?  32767.0f : value;
+            value = (value < -32768.0f) ? -32768.0f : value;
+            samples[i] = static_cast<detail::PcmFormat::sample_type>(value);
+        }
+
+        std::memcpy(period, samples, sizeof(samples));
+    }
+
+
+private:
+    float factor;
+}; // class Gain
+
+// Energy voice activity detector.  A period is voiced when its power is
+// 'threshold_db' above the noise floor, which drops to any quieter period at
+// once and creeps up by about half a dB per second otherwise.  Activity is
+// held for 'hangover_period_count' periods after the last voiced one so
+// word endings are kept.  With 'gate' set, inactive periods are zeroed, e.g.
+// ahead of a send sink.
+class VoiceActivity
+{
+public:
+    explicit VoiceActivity(const float threshold_db              = 9.0f,
+                           const unsigned int hangover_period_count = 25,
+                           const bool gate                          = false)
+        : threshold_ratio(std::pow(10.0f, threshold_db / 10.0f)),
+          hangover_period_count(hangover_period_count),
+          gate(gate),
+          noise_floor(full_scale_power),
+          hangover_left(0),
+          is_active(false),
+          active_total(0)
+    {}
+
+    void
+    operator()(period_type &period)
+    {
+        static const std::size_t sample_count =
+            detail::PcmFormat::period_frame_size
+            * detail::PcmFormat::channel_count;
+
+        detail::PcmFormat::sample_type samples[sample_count];
+        std::memcpy(samples, period, sizeof(samples));
+
+        const detail::LevelSums sums = detail::measure_level(samples,
+                                                             sample_count);
+
+        // at least one LSB, so digital silence still has a floor
+        float power = static_cast<float>(sums.square_sum) / sample_count;
+        power = (power > 1.0f) ? power : 1.0f;
+
+        noise_floor *= floor_rise;
+        noise_floor  = (power < noise_floor) ? power : noise_floor;
+
+        if (power > (noise_floor * threshold_ratio))
+            hangover_left = hangover_period_count + 1;
+
+        is_active      = hangover_left > 0;
+        hangover_left -= is_active;
+        active_total  += is_active;
+
+        if (gate && !is_active)
+            std::memset(period, 0, sizeof(period_type));
+    }
+
+    // whether the last period was voiced (or in the hangover)
+    bool
+    active() const noexcept
+    {
+        return is_active;
+    }
+
+    std::uint64_t
+    active_count() const noexcept
+    {
+        return active_total;
+    }
+
+
+private:
+    static constexpr float full_scale_power = 32768.0f * 32768.0f;
+
+    // per period, about 0.5 dB/s at 125 periods per second
+    static constexpr float floor_rise = 1.001f;
+
+    float threshold_ratio;
+    unsigned int hangover_period_count;
+    bool gate;
+    float noise_floor;
+    unsigned int hangover_left;
+    bool is_active;
+    std::uint64_t active_total;
+}; // class VoiceActivity
+
+// append every period to a (binary) stream
+class FileTap
+{
+public:
+    explicit FileTap(std::ostream &output)
+        : output(&output)
+    {}
+
+    void
+    operator()(period_type &period) const
+    {
+        output->write(period, sizeof(period_type));
+    }
+
+
+private:
+    std::ostream *output;
+}; // class FileTap
+
+// cancel the echo of the next period queued on 'reference'
+template<std::size_t partition_count = 8>
+class EchoCancellation
+{
+public:
+    EchoCancellation(EchoCanceller<partition_count> &canceller,
+                     ReferenceTap &reference)
+        : canceller(&canceller),
+          reference(&reference)
+    {}
+
+    void
+    operator()(period_type &period)
+    {
+        period_type reference_period;
+
+        (void) reference->pop(reference_period);
+
+        canceller->process(period, reference_period, period);
+    }
+
+
+private:
+    EchoCanceller<partition_count> *canceller;
+    ReferenceTap *reference;
+}; // class EchoCancellation
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_STAGES_HPP
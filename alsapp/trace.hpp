@@ -0,0 +1,275 @@
+#ifndef ALSAPP_TRACE_HPP
+#define ALSAPP_TRACE_HPP
+
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include "alsapp/detail/trace_buffer.hpp" // alsapp::detail::TraceBuffer
+#include <atomic>                         // std::atomic
+#include <chrono>                         // std::chrono::steady_clock
+#include <csignal>                        // std::signal, std::sig_atomic_t
+#include <cstddef>                        // std::size_t
+#include <cstdint>                        // std::uint[32|64]_t
+#include <fstream>                        // std::ofstream
+#include <iterator>                       // std::back_inserter
+#include <memory>                         // std::unique_ptr
+#include <ostream>                        // std::ostream
+#include <thread>                         // std::this_thread::get_id
+#include <vector>                         // std::vector
+
+
+
+// EXTERNAL API
+// =============================================================================
+namespace alsapp {
+
+// Per-period latency tracer.  Each thread records into its own lock-free
+// ring, so recording costs a clock read and a handful of stores.  Only every
+// 'sample_interval'th period is traced (0 disables tracing altogether).
+class Tracer
+{
+public:
+    // where along the capture -> recognition path an event was recorded
+    enum class Stage : std::uint8_t
+    {
+        capture,  // period read from the device
+        enqueue,  // period packed into an outgoing request
+        send,     // request written to the stream
+        response  // response received for the period
+    };
+
+    struct Event
+    {
+        std::uint64_t timestamp; // nanoseconds, steady clock
+        std::uint64_t period;    // index of the traced period
+        float stability;         // result stability (response only)
+        std::uint32_t thread;    // recording thread slot
+        Stage stage;
+    };
+
+private:
+    // Tracer Settings
+    // -------------------------------------------------------------------------
+    // most distinct threads that may record into one tracer
+    static const std::size_t max_threads = 16;
+
+    // events retained per thread
+    static const std::size_t thread_capacity = 4096;
+
+    typedef detail::TraceBuffer<Event, thread_capacity> buffer_type;
+
+
+public:
+    explicit Tracer(const std::uint64_t sample_interval = 1)
+        : sample_interval(sample_interval),
+          identity(++tracer_count),
+          thread_count(0),
+          buffers((sample_interval != 0) ? new buffer_type[max_threads]
+                                         : nullptr),
+          owners((sample_interval != 0)
+                 ? new std::atomic<std::thread::id>[max_threads]
+                 : nullptr)
+    {
+        for (std::size_t i = 0; enabled() && (i < max_threads); ++i)
+            owners[i].store(std::thread::id(), std::memory_order_relaxed);
+    }
+
+    bool
+    enabled() const noexcept
+    {
+        return sample_interval != 0;
+    }
+
+    // whether events for 'period' should be recorded
+    bool
+    sampled(const std::uint64_t period) const noexcept
+    {
+        return enabled() && ((period % sample_interval) == 0);
+    }
+
+    // record an event for a sampled period on the calling thread
+    void
+    record(const Stage stage,
+           const std::uint64_t period,
+           const float stability = 0.0f) noexcept
+    {
+        if (!sampled(period))
+            return;
+
+        buffer_type *const buffer = local_buffer();
+        if (buffer == nullptr)
+            return; // out of thread slots, drop
+
+        buffer->push(Event {
+            now(),
+            period,
+            stability,
+            static_cast<std::uint32_t>(buffer - buffers.get()),
+            stage
+        });
+    }
+
+    // collect retained events from every thread
+    std::vector<Event>
+    events() const
+    {
+        std::vector<Event> collected;
+
+        const std::size_t count = claimed_threads();
+        for (std::size_t i = 0; i < count; ++i)
+            buffers[i].snapshot(std::back_inserter(collected));
+
+        return collected;
+    }
+
+    // write retained events as Chrome trace / Perfetto JSON
+    void
+    write_chrome_trace(std::ostream &output) const
+    {
+        static const char *const stage_names[] = {
+            "capture", "enqueue", "send", "response"
+        };
+
+        // a period is an async slice from capture to its first response
+        static const char stage_phases[] = { 'b', 'n', 'n', 'e' };
+
+        const std::vector<Event> collected = events();
+
+        output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        const char *separator = "";
+        for (const Event &event : collected) {
+            const std::size_t stage = static_cast<std::size_t>(event.stage);
+
+            output << separator
+                   << "{\"name\":\"period\",\"cat\":\"alsapp\""
+                   << ",\"ph\":\"" << stage_phases[stage] << '"'
+                   << ",\"id\":" << event.period
+                   << ",\"pid\":1,\"tid\":" << event.thread
+                   << ",\"ts\":" << (event.timestamp / 1000)
+                   << '.' << ((event.timestamp / 100) % 10)
+                   << ",\"args\":{\"stage\":\"" << stage_names[stage] << '"';
+
+            if (event.stage == Stage::response)
+                output << ",\"stability\":" << event.stability;
+
+            output << "}}";
+            separator = ",\n";
+        }
+
+        output << "]}\n";
+    }
+
+    // write trace to 'path', returns false on I/O failure
+    bool
+    dump(const char *const path) const
+    {
+        std::ofstream output(path);
+
+        write_chrome_trace(output);
+
+        return static_cast<bool>(output);
+    }
+
+    // request a dump on receipt of 'signal_number' (e.g. SIGUSR1), the
+    // request is picked up by polling 'dump_requested' -- from a thread that
+    // may block, not a real-time one, as dump() allocates and writes a file
+    static void
+    dump_on_signal(const int signal_number)
+    {
+        (void) std::signal(signal_number,
+                           &Tracer::handle_dump_signal);
+    }
+
+    // true once per delivered dump signal
+    static bool
+    dump_requested() noexcept
+    {
+        if (dump_signaled == 0)
+            return false;
+
+        dump_signaled = 0;
+        return true;
+    }
+
+
+private:
+    static std::uint64_t
+    now() noexcept
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            ).count()
+        );
+    }
+
+    std::size_t
+    claimed_threads() const noexcept
+    {
+        const std::size_t count = thread_count.load(std::memory_order_acquire);
+
+        return (count < max_threads) ? count : max_threads;
+    }
+
+    // This thread's ring, claimed on first use.  The last tracer used is
+    // cached per thread (by identity, an address may be reused); switching
+    // between tracers finds the ring already claimed rather than another.
+    buffer_type *
+    local_buffer() noexcept
+    {
+        struct Slot
+        {
+            std::uint64_t owner;
+            buffer_type *buffer;
+        };
+        thread_local Slot slot = { 0, nullptr };
+
+        if (slot.owner != identity) {
+            slot.owner  = identity;
+            slot.buffer = claim_buffer();
+        }
+
+        return slot.buffer;
+    }
+
+    buffer_type *
+    claim_buffer() noexcept
+    {
+        const std::thread::id self = std::this_thread::get_id();
+
+        const std::size_t count = claimed_threads();
+        for (std::size_t i = 0; i < count; ++i)
+            if (owners[i].load(std::memory_order_relaxed) == self)
+                return &buffers[i];
+
+        const std::size_t index =
+            thread_count.fetch_add(1, std::memory_order_acq_rel);
+        if (index >= max_threads)
+            return nullptr;
+
+        owners[index].store(self, std::memory_order_relaxed);
+        return &buffers[index];
+    }
+
+    static void
+    handle_dump_signal(int)
+    {
+        dump_signaled = 1;
+    }
+
+    const std::uint64_t sample_interval;
+    const std::uint64_t identity; // never reused, unlike 'this'
+    std::atomic<std::size_t> thread_count;
+    std::unique_ptr<buffer_type[]> buffers;
+    std::unique_ptr<std::atomic<std::thread::id>[]> owners; // of 'buffers'
+
+    static volatile std::sig_atomic_t dump_signaled;
+    static std::atomic<std::uint64_t> tracer_count;
+}; // class Tracer
+
+inline volatile std::sig_atomic_t Tracer::dump_signaled = 0;
+inline std::atomic<std::uint64_t> Tracer::tracer_count(0);
+
+} // namespace alsapp
+
+#endif  // ifndef ALSAPP_TRACE_HPP
@@ -0,0 +1,586 @@
+// Transcribe recorded audio as fast as the service allows: files are memory
+// mapped, long ones are split at silences into segments, and the segments
+// are recognized on parallel streams with no real-time pacing.  Each
+// segment's result is written as one JSON line.
+//
+// usage: batch_transcribe [--NAME VALUE]... PATH...
+//
+// A PATH is a raw LINEAR16 16 kHz mono file, a directory of them, or
+// '@manifest' naming a file that lists one path per line.
+#include <grpc++/grpc++.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "google/cloud/speech/v1/cloud_speech.grpc.pb.h"
+#include "transcribe_options.hpp"
+
+
+using google::cloud::speech::v1::RecognitionConfig;
+using google::cloud::speech::v1::Speech;
+using google::cloud::speech::v1::StreamingRecognizeRequest;
+using google::cloud::speech::v1::StreamingRecognizeResponse;
+
+typedef std::chrono::steady_clock Clock;
+typedef std::int16_t sample_type;
+
+// 16-bit, 16 kHz mono
+static const std::size_t sample_rate = 16000;
+
+// silence is judged over 10ms windows
+static const std::size_t window_size = sample_rate / 100;
+
+// largest audio_content per request
+static const std::size_t chunk_size = 64 * 1024;
+
+
+static const char usage[] =
+    "usage: batch_transcribe [--NAME VALUE]... PATH...\n"
+    "\n"
+    "  PATH                      raw LINEAR16 16 kHz mono file, directory\n"
+    "                            of them, or @manifest listing paths\n"
+    "  --jobs N                  concurrent streams (default 16)\n"
+    "  --rate N                  streams started per second, 0 unlimited\n"
+    "  --output FILE             JSONL results (default stdout)\n"
+    "  --endpoint HOST[:PORT]    Speech service address\n"
+    "  --insecure 0|1            plaintext channel, no credentials\n"
+    "  --language CODE           BCP-47 language code (default en)\n"
+    "  --segment_sec N           split files longer than this (default 50)\n"
+    "  --search_sec N            look this far back for silence (default 10)\n"
+    "  --silence_level N         mean |sample| counted as silence (300)\n"
+    "  --silence_msec N          shortest silence to cut at (default 300)\n";
+
+struct BatchOptions
+{
+    long jobs            = 16;
+    double rate          = 0.0;
+    std::string output;
+    std::string endpoint = "speech.googleapis.com";
+    bool insecure        = false;
+    std::string language = "en";
+    long segment_sec     = 50;
+    long search_sec      = 10;
+    long silence_level   = 300;
+    long silence_msec    = 300;
+    std::vector<std::string> paths;
+}; // struct BatchOptions
+
+// A memory-mapped audio file
+class AudioFile
+{
+public:
+    explicit AudioFile(const std::string &path)
+        : path(path),
+          samples(nullptr),
+          size(0)
+    {
+        const int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (descriptor < 0)
+            return;
+
+        struct stat status;
+        if ((::fstat(descriptor, &status) == 0) && (status.st_size > 0)) {
+            void *const mapped = ::mmap(nullptr,
+                                        status.st_size,
+                                        PROT_READ,
+                                        MAP_PRIVATE,
+                                        descriptor,
+                                        0);
+            if (mapped != MAP_FAILED) {
+                // read once, front to back
+                (void) ::madvise(mapped, status.st_size, MADV_SEQUENTIAL);
+
+                samples = static_cast<const sample_type *>(mapped);
+                size    = static_cast<std::size_t>(status.st_size);
+            }
+        }
+
+        (void) ::close(descriptor);
+    }
+
+    ~AudioFile()
+    {
+        if (samples != nullptr)
+            (void) ::munmap(const_cast<sample_type *>(samples), size);
+    }
+
+    AudioFile(const AudioFile &)            = delete;
+    AudioFile &operator=(const AudioFile &) = delete;
+
+    std::size_t
+    sample_count() const
+    {
+        return size / sizeof(sample_type);
+    }
+
+    const std::string path;
+    const sample_type *samples; // null if it couldn't be mapped
+    std::size_t size;           // bytes
+}; // class AudioFile
+
+struct Segment
+{
+    const AudioFile *file;
+    std::size_t index; // within the file
+    std::size_t first; // sample
+    std::size_t last;  // one past
+}; // struct Segment
+
+// Spaces stream starts at least 1/rate apart, across threads
+class RateLimiter
+{
+public:
+    explicit RateLimiter(const double rate)
+        : interval((rate > 0.0)
+                   ? std::chrono::duration_cast<Clock::duration>(
+                         std::chrono::duration<double>(1.0 / rate)
+                     )
+                   : Clock::duration::zero()),
+          next(Clock::now())
+    {}
+
+    void
+    acquire()
+    {
+        if (interval == Clock::duration::zero())
+            return;
+
+        Clock::time_point start;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            start = std::max(next, Clock::now());
+            next  = start + interval;
+        }
+
+        std::this_thread::sleep_until(start);
+    }
+
+
+private:
+    const Clock::duration interval;
+    std::mutex mutex;
+    Clock::time_point next;
+}; // class RateLimiter
+
+
+static bool
+parse_arguments(const int argc,
+                char *const argv[],
+                BatchOptions &options,
+                std::string &error)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument(argv[i]);
+
+        if (argument.compare(0, 2, "--") != 0) {
+            options.paths.push_back(argument);
+            continue;
+        }
+
+        if (++i == argc) {
+            error = "missing value for '" + argument + "'";
+            return false;
+        }
+
+        const std::string value(argv[i]);
+        bool valid = true;
+
+        // the same strict parsing as streaming_transcribe options
+        if (argument == "--jobs")
+            valid = TranscribeOptions::parse(value, options.jobs);
+        else if (argument == "--rate")
+            valid = TranscribeOptions::parse(value, options.rate);
+        else if (argument == "--output")
+            options.output = value;
+        else if (argument == "--endpoint")
+            options.endpoint = value;
+        else if (argument == "--insecure")
+            valid = TranscribeOptions::parse(value, options.insecure);
+        else if (argument == "--language")
+            options.language = value;
+        else if (argument == "--segment_sec")
+            valid = TranscribeOptions::parse(value, options.segment_sec);
+        else if (argument == "--search_sec")
+            valid = TranscribeOptions::parse(value, options.search_sec);
+        else if (argument == "--silence_level")
+            valid = TranscribeOptions::parse(value, options.silence_level);
+        else if (argument == "--silence_msec")
+            valid = TranscribeOptions::parse(value, options.silence_msec);
+        else {
+            error = "unknown option '" + argument + "'";
+            return false;
+        }
+
+        if (!valid) {
+            error = "invalid value '" + value + "' for '" + argument + "'";
+            return false;
+        }
+    }
+
+    if (options.paths.empty()) {
+        error = "no PATH given";
+        return false;
+    }
+
+    const bool in_range = (options.jobs > 0) && (options.rate >= 0.0)
+                       && (options.segment_sec > 0) && (options.search_sec >= 0)
+                       && (options.search_sec < options.segment_sec)
+                       && (options.silence_level >= 0)
+                       && (options.silence_msec > 0);
+
+    if (!in_range)
+        error = "option out of range";
+
+    return in_range;
+}
+
+// expand directories and manifests into file paths
+static void
+collect_paths(const std::string &path,
+              std::vector<std::string> &files)
+{
+    if (path[0] == '@') {
+        std::ifstream manifest(path.substr(1));
+        std::string line;
+
+        while (std::getline(manifest, line))
+            if (!line.empty() && (line[0] != '#'))
+                files.push_back(line);
+
+        return;
+    }
+
+    DIR *const directory = ::opendir(path.c_str());
+    if (directory == nullptr) {
+        files.push_back(path);
+        return;
+    }
+
+    std::vector<std::string> entries;
+    while (const dirent *const entry = ::readdir(directory))
+        if (entry->d_name[0] != '.')
+            entries.push_back(path + "/" + entry->d_name);
+
+    (void) ::closedir(directory);
+
+    std::sort(entries.begin(), entries.end()); // stable output order
+    files.insert(files.end(), entries.begin(), entries.end());
+}
+
+// mean magnitude of the window starting at 'first'
+static long
+window_level(const sample_type *const samples,
+             const std::size_t first)
+{
+    long total = 0;
+
+    for (std::size_t i = first; i < first + window_size; ++i)
+        total += std::abs(static_cast<long>(samples[i]));
+
+    return total / static_cast<long>(window_size);
+}
+
+// Where to end a segment ending no later than 'limit': the middle of the
+// silence closest to 'limit' within the search span, else its quietest window.
+static std::size_t
+find_cut(const AudioFile &file,
+         const std::size_t earliest,
+         const std::size_t limit,
+         const BatchOptions &options)
+{
+    const std::size_t silence_windows = std::max<std::size_t>(
+        1,
+        static_cast<std::size_t>(options.silence_msec) * sample_rate
+        / (1000 * window_size)
+    );
+
+    std::size_t quietest       = limit;
+    long quietest_level        = -1;
+    std::size_t silent_windows = 0;
+
+    // walk backwards from the limit
+    for (std::size_t end = limit; end >= earliest + window_size;
+         end -= window_size) {
+        const std::size_t first = end - window_size;
+        const long level = window_level(file.samples, first);
+
+        if ((quietest_level < 0) || (level < quietest_level)) {
+            quietest       = first + (window_size / 2);
+            quietest_level = level;
+        }
+
+        if (level > options.silence_level) {
+            silent_windows = 0;
+            continue;
+        }
+
+        if (++silent_windows == silence_windows)
+            return first + ((silence_windows * window_size) / 2);
+    }
+
+    return quietest;
+}
+
+static std::vector<Segment>
+split(const AudioFile &file,
+      const BatchOptions &options)
+{
+    const std::size_t segment_size =
+        static_cast<std::size_t>(options.segment_sec) * sample_rate;
+    const std::size_t search_size =
+        static_cast<std::size_t>(options.search_sec) * sample_rate;
+    const std::size_t sample_count = file.sample_count();
+
+    std::vector<Segment> segments;
+
+    for (std::size_t first = 0; first < sample_count; ) {
+        std::size_t last = sample_count;
+
+        if ((sample_count - first) > segment_size)
+            last = find_cut(file,
+                            first + segment_size - search_size,
+                            first + segment_size,
+                            options);
+
+        segments.push_back(Segment{ &file, segments.size(), first, last });
+        first = last;
+    }
+
+    return segments;
+}
+
+static void
+write_json_string(std::string &line,
+                  const std::string &text)
+{
+    line += '"';
+
+    for (const char c : text) {
+        switch (c) {
+        case '"':  line += "\\\""; break;
+        case '\\': line += "\\\\"; break;
+        case '\n': line += "\\n";  break;
+        case '\r': line += "\\r";  break;
+        case '\t': line += "\\t";  break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[7];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                line += escaped;
+            } else {
+                line += c;
+            }
+        }
+    }
+
+    line += '"';
+}
+
+// recognize one segment, returning its JSON line
+static std::string
+transcribe(Speech::Stub &speech,
+           const Segment &segment,
+           const BatchOptions &options)
+{
+    grpc::ClientContext context;
+    auto streamer = speech.StreamingRecognize(&context);
+
+    StreamingRecognizeRequest request;
+    auto *const streaming_config   = request.mutable_streaming_config();
+    auto *const recognition_config = streaming_config->mutable_config();
+
+    recognition_config->set_language_code(options.language);
+    recognition_config->set_sample_rate_hertz(sample_rate);
+    recognition_config->set_encoding(RecognitionConfig::LINEAR16);
+    streaming_config->set_interim_results(false);
+
+    const Clock::time_point start = Clock::now();
+
+    // audio is written as fast as the stream accepts it
+    std::thread writer([&] {
+        if (!streamer->Write(request))
+            return;
+
+        const char *const audio =
+            reinterpret_cast<const char *>(segment.file->samples);
+        const std::size_t end = segment.last * sizeof(sample_type);
+
+        StreamingRecognizeRequest audio_request;
+
+        for (std::size_t offset = segment.first * sizeof(sample_type);
+             offset < end;
+             offset += chunk_size) {
+            audio_request.set_audio_content(audio + offset,
+                                            std::min(chunk_size, end - offset));
+            if (!streamer->Write(audio_request))
+                return;
+        }
+
+        streamer->WritesDone();
+    });
+
+    std::string transcript;
+    float confidence_total = 0.0f;
+    int final_count = 0;
+
+    StreamingRecognizeResponse response;
+    while (streamer->Read(&response))
+        for (int r = 0; r < response.results_size(); ++r) {
+            const auto &result = response.results(r);
+
+            if (!result.is_final() || (result.alternatives_size() == 0))
+                continue;
+
+            const auto &alternative = result.alternatives(0);
+            transcript       += alternative.transcript();
+            confidence_total += alternative.confidence();
+            ++final_count;
+        }
+
+    writer.join();
+    const grpc::Status status = streamer->Finish();
+
+    const double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::string line("{\"file\":");
+    write_json_string(line, segment.file->path);
+    line += ",\"segment\":"   + std::to_string(segment.index)
+          + ",\"start_sec\":" + std::to_string(double(segment.first)
+                                               / sample_rate)
+          + ",\"end_sec\":"   + std::to_string(double(segment.last)
+                                               / sample_rate)
+          + ",\"elapsed_sec\":" + std::to_string(seconds);
+
+    if (status.ok()) {
+        line += ",\"transcript\":";
+        write_json_string(line, transcript);
+        line += ",\"confidence\":"
+              + std::to_string((final_count > 0)
+                               ? (confidence_total / final_count)
+                               : 0.0f);
+    } else {
+        line += ",\"error\":";
+        write_json_string(line, status.error_message());
+    }
+
+    return line + "}\n";
+}
+
+int
+main(int argc,
+     char *argv[])
+{
+    BatchOptions options;
+    std::string error;
+
+    if (!parse_arguments(argc, argv, options, error)) {
+        std::cerr << error << "\n\n" << usage;
+        return 2;
+    }
+
+    std::vector<std::string> paths;
+    for (const std::string &path : options.paths)
+        collect_paths(path, paths);
+
+    // map everything up front, segments point into the mappings
+    std::vector<std::unique_ptr<AudioFile>> files;
+    std::vector<Segment> segments;
+
+    for (const std::string &path : paths) {
+        files.emplace_back(new AudioFile(path));
+
+        if (files.back()->samples == nullptr) {
+            std::cerr << "skipping " << path << ": unreadable or empty\n";
+            continue;
+        }
+
+        const std::vector<Segment> split_segments = split(*files.back(),
+                                                          options);
+        segments.insert(segments.end(),
+                        split_segments.begin(),
+                        split_segments.end());
+    }
+
+    std::ofstream output_file;
+    if (!options.output.empty())
+        output_file.open(options.output, std::ofstream::trunc);
+    if (!options.output.empty() && !output_file.is_open()) {
+        std::cerr << "failed to open output file '" << options.output << "'\n";
+        return 1;
+    }
+    std::ostream &output = options.output.empty() ? std::cout : output_file;
+
+    auto channel = grpc::CreateChannel(
+        options.endpoint,
+        options.insecure ? grpc::InsecureChannelCredentials()
+                         : grpc::GoogleDefaultCredentials()
+    );
+    std::unique_ptr<Speech::Stub> speech(Speech::NewStub(channel));
+
+    RateLimiter limiter(options.rate);
+    std::atomic<std::size_t> next_segment(0);
+    std::atomic<std::size_t> failed(0);
+    std::mutex output_mutex;
+
+    const Clock::time_point start = Clock::now();
+
+    std::vector<std::thread> workers;
+    const std::size_t worker_count =
+        std::min(static_cast<std::size_t>(options.jobs), segments.size());
+
+    for (std::size_t i = 0; i < worker_count; ++i)
+        workers.emplace_back([&] {
+            for (std::size_t index; (index = next_segment++) < segments.size(); ) {
+                limiter.acquire();
+
+                const std::string line = transcribe(*speech,
+                                                    segments[index],
+                                                    options);
+
+                failed += line.find(",\"error\":") != std::string::npos;
+
+                std::lock_guard<std::mutex> lock(output_mutex);
+                output << line;
+            }
+        });
+
+    for (std::thread &worker : workers)
+        worker.join();
+
+    output.flush();
+
+    std::size_t audio_bytes = 0;
+    for (const Segment &segment : segments)
+        audio_bytes += (segment.last - segment.first) * sizeof(sample_type);
+
+    const double wall = std::chrono::duration<double>(Clock::now()
+                                                      - start).count();
+    const double audio_seconds =
+        double(audio_bytes) / (sample_rate * sizeof(sample_type));
+
+    std::cerr << files.size() << " files, " << segments.size()
+              << " segments (" << failed << " failed), " << audio_seconds
+              << "s of audio in " << wall << "s ("
+              << ((wall > 0.0) ? (audio_seconds / wall) : 0.0)
+              << "x real time)" << std::endl;
+
+    return failed != 0;
+}
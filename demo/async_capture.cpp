@@ -0,0 +1,58 @@
+// capture from every device named on the command line on one thread
+#include "alsapp/async_microphone.hpp"
+#include <iostream>
+#include <stdexcept>
+
+
+#ifndef CAPTURE_SECONDS
+#define CAPTURE_SECONDS 5
+#endif // #ifndef CAPTURE_SECONDS
+
+using alsapp::AsyncMicrophone;
+using alsapp::DetachedTask;
+using alsapp::Reactor;
+
+static DetachedTask
+capture(Reactor &reactor,
+        const char *const device_name)
+{
+    AsyncMicrophone microphone(reactor, device_name);
+
+    std::size_t size_left = CAPTURE_SECONDS * 16000 * 2;
+    std::size_t wakeups   = 0;
+
+    auto periods = microphone.periods(16);
+
+    while (size_left > 0) {
+        const AsyncMicrophone::Chunk *const chunk = co_await periods.next();
+
+        size_left -= (chunk->size < size_left) ? chunk->size : size_left;
+        ++wakeups;
+    }
+
+    std::cout << device_name << ": " << wakeups << " wakeups, "
+              << microphone.overrun_count() << " overruns" << std::endl;
+}
+
+int
+main(int argc,
+     char *argv[])
+{
+    Reactor reactor;
+
+    if (argc < 2)
+        capture(reactor, "default");
+
+    for (int i = 1; i < argc; ++i)
+        capture(reactor, argv[i]);
+
+    // a capture that fails (e.g. a device that won't open) surfaces here
+    try {
+        reactor.run();
+    } catch (const std::runtime_error &error) {
+        std::cerr << "async_capture: " << error.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
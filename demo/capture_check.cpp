@@ -0,0 +1,572 @@
+#include "alsapp/channels.hpp"
+#include "alsapp/microphone.hpp"
+#include "alsapp/multichannel_microphone.hpp"
+#include "alsapp/open_microphones.hpp"
+#include <alsa/asoundlib.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+// Exercises the capture path without a sound card, against the PCMs in
+// 'asoundrc': construction, negotiation, reads, partial (batch) reads,
+// overrun recovery, ownership transfer and shutdown.  Short reads and
+// overruns come from a harness around snd_pcm_readi (see below), as these
+// PCMs are never interrupted and never overrun.  With '--stress', many
+// Microphones capture concurrently instead and timing, descriptor and memory
+// growth are reported.  Exits non-zero if anything failed.  Run from demo/
+// (the file PCM reads audio.raw relative to the working directory).
+//
+// usage: capture_check [--stress [microphones] [seconds]] [device]
+//
+// 'device' (default alsapp_null) is the PCM checked for overruns and
+// stressed, e.g. a real 'hw:0' to check paced capture.
+
+#ifndef ASOUNDRC
+#define ASOUNDRC "asoundrc"
+#endif // #ifndef ASOUNDRC
+
+#ifndef AUDIO_FILE
+#define AUDIO_FILE "audio.raw"
+#endif // #ifndef AUDIO_FILE
+
+using alsapp::Microphone;
+
+typedef std::chrono::steady_clock Clock;
+
+static int failure_count = 0;
+
+static void
+report(const char *const check,
+       const bool passed,
+       const std::string &detail = std::string())
+{
+    std::cout << (passed ? "ok     " : "FAILED ") << check;
+    if (!detail.empty())
+        std::cout << " (" << detail << ')';
+    std::cout << std::endl;
+
+    failure_count += !passed;
+}
+
+// merge our PCM definitions into the global configuration
+static void
+load_asoundrc(const char *const path)
+{
+    snd_input_t *input;
+
+    alsapp::detail::check_action("update configuration", snd_config_update());
+    alsapp::detail::check_action("open PCM definitions",
+                                 snd_input_stdio_open(&input, path, "r"));
+
+    const int status = snd_config_load(snd_config, input);
+    (void) snd_input_close(input);
+
+    alsapp::detail::check_action("load PCM definitions", status);
+}
+
+static std::size_t
+open_descriptor_count()
+{
+    std::size_t count = 0;
+
+    if (DIR *const directory = opendir("/proc/self/fd")) {
+        while (readdir(directory) != nullptr)
+            ++count;
+        (void) closedir(directory);
+    }
+
+    return count;
+}
+
+static long
+resident_kib()
+{
+    long pages = 0;
+    long resident = 0;
+
+    std::ifstream statm("/proc/self/statm");
+    statm >> pages >> resident;
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Read harness: defined here, snd_pcm_readi takes the place of libasound's
+// for every call alsapp makes.  Armed, it cuts the next read short, as a
+// signal or a stream stopped mid-read would, or fails it with -EPIPE, as an
+// overrun would.  Otherwise (and for the frames a short read does take) the
+// real PCM is read, so the stream stays intact.
+static std::atomic<long> short_read_frames(-1); // next read's frames, -1 off
+static std::atomic_bool overrun_next_read(false);
+
+extern "C" snd_pcm_sframes_t
+snd_pcm_readi(snd_pcm_t *pcm,
+              void *buffer,
+              snd_pcm_uframes_t size)
+{
+    typedef snd_pcm_sframes_t (*readi_type)(snd_pcm_t *,
+                                            void *,
+                                            snd_pcm_uframes_t);
+    static const readi_type alsa_readi =
+        reinterpret_cast<readi_type>(dlsym(RTLD_NEXT, "snd_pcm_readi"));
+
+    if (overrun_next_read.exchange(false))
+        return -EPIPE;
+
+    const long frames = short_read_frames.exchange(-1);
+    if ((frames >= 0) && (static_cast<snd_pcm_uframes_t>(frames) < size))
+        size = static_cast<snd_pcm_uframes_t>(frames);
+
+    return (size > 0) ? alsa_readi(pcm, buffer, size) : 0;
+}
+
+static void
+check_construction()
+{
+    try {
+        Microphone microphone("alsapp_null");
+        report("open and negotiate alsapp_null", true);
+    } catch (const std::exception &error) {
+        report("open and negotiate alsapp_null", false, error.what());
+    }
+
+    bool threw = false;
+    try {
+        Microphone microphone("alsapp_missing");
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    report("unknown device throws", threw);
+
+    std::error_code error;
+    Microphone unusable("alsapp_missing", error);
+    report("unknown device sets error_code", static_cast<bool>(error),
+           error.message());
+}
+
+static void
+check_reads()
+{
+    Microphone microphone("alsapp_null");
+    Microphone::period_type periods[16];
+
+    const std::size_t size = microphone.read(periods);
+    report("read fills the buffer", size == sizeof(periods),
+           std::to_string(size) + " bytes");
+
+    std::error_code error;
+    const std::size_t one = microphone.read(periods[0], error);
+    report("no-throw read of one period",
+           !error && (one == sizeof(periods[0])),
+           error.message());
+}
+
+static void
+check_file_contents()
+{
+    std::ifstream file(AUDIO_FILE, std::ifstream::binary);
+    const std::string expected((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+
+    static Microphone::period_type periods[64];
+    const std::size_t compared = std::min(sizeof(periods), expected.size());
+
+    Microphone microphone("alsapp_file");
+    (void) microphone.read(periods);
+
+    report("alsapp_file captures " AUDIO_FILE,
+           (compared > 0)
+           && (std::memcmp(periods, expected.data(), compared) == 0),
+           std::to_string(compared) + " bytes compared");
+}
+
+// batches from alsapp_file, interrupted every third read, must still deliver
+// AUDIO_FILE in whole periods
+static void
+check_batches()
+{
+    typedef Microphone::Batch::Status Status;
+
+    static const std::size_t period_frame_size =
+        Microphone::config_type::period_frame_size;
+
+    std::ifstream file(AUDIO_FILE, std::ifstream::binary);
+    const std::string expected((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+
+    Microphone microphone("alsapp_file");
+    Microphone::period_type periods[4];
+    std::string delivered;
+
+    std::uint64_t expected_frame = 0;
+    std::size_t short_count = 0;
+    bool contiguous  = true;
+    bool bounded     = true;
+    bool complete    = true;
+    bool interrupted = true;
+
+    for (int i = 0; i < 100; ++i) {
+        // fewer frames than a batch asks for, which is over 3 periods
+        const bool cut = (i % 3) == 1;
+        if (cut)
+            short_read_frames = (i * 37) % (3 * period_frame_size);
+
+        const Microphone::Batch batch = microphone.read_batch(periods);
+
+        if (cut) {
+            interrupted &= batch.status == Status::short_read;
+            short_count += batch.status == Status::short_read;
+        } else {
+            complete &= (batch.status == Status::complete)
+                     && (batch.period_count > 0);
+        }
+        bounded    &= batch.period_count <= 4;
+        contiguous &= batch.first_frame == expected_frame;
+
+        expected_frame += batch.period_count * period_frame_size;
+        delivered.append(periods[0], batch.period_count * sizeof(periods[0]));
+    }
+
+    // an overrun drops the carried frames, the stream resumes whole
+    short_read_frames = period_frame_size / 2;
+    (void) microphone.read_batch(periods);
+    overrun_next_read = true;
+
+    Microphone::Batch batch = microphone.read_batch(periods);
+    const bool failed = (batch.status == Status::failed)
+                     && (batch.error == std::errc::broken_pipe)
+                     && (batch.period_count == 0);
+    const std::string failure = batch.error.message();
+    microphone.recover(batch.error);
+    const bool recovered = !batch.error;
+
+    batch = microphone.read_batch(periods);
+
+    const std::size_t compared = std::min(delivered.size(), expected.size());
+
+    report("uninterrupted batches complete", complete);
+    report("interrupted batches report short reads", interrupted,
+           std::to_string(short_count) + " short");
+    report("batches hold at most capacity periods", bounded);
+    report("batch frame positions are contiguous", contiguous);
+    report("short reads carry partial periods intact",
+           (compared > 0)
+           && (delivered.compare(0, compared, expected, 0, compared) == 0),
+           std::to_string(compared) + " bytes compared");
+    report("batch overrun fails with broken_pipe", failed, failure);
+    report("batch recovers from overrun",
+           recovered && (batch.status == Status::complete)
+           && (batch.period_count > 0));
+}
+
+static void
+check_overrun(const char *const device)
+{
+    std::error_code error;
+    Microphone microphone(device, error);
+    Microphone::period_type period;
+
+    if (error) {
+        report("open overrun device", false, error.message());
+        return;
+    }
+
+    // through the read harness, the read reports it and recover() prepares
+    (void) microphone.read(period, error);
+    overrun_next_read = true;
+    (void) microphone.read(period, error);
+    const bool reported = error == std::errc::broken_pipe;
+
+    microphone.recover(error);
+    if (!error)
+        (void) microphone.read(period, error);
+    report("recover from harness overrun", reported && !error,
+           error.message());
+
+    // real: only a paced device can overrun
+    (void) microphone.read(period, error);
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    (void) microphone.read(period, error);
+
+    if (error != std::errc::broken_pipe) {
+        std::cout << "skip   " << device << " did not overrun (not paced)"
+                  << std::endl;
+        return;
+    }
+
+    microphone.recover(error);
+    if (!error)
+        (void) microphone.read(period, error);
+    report("recover from real overrun", !error, error.message());
+}
+
+// downmix every frame of 'channel_count' channels of 'value' both ways
+template<std::size_t channel_count,
+         typename Sample>
+static bool
+downmixes_to(const Sample value)
+{
+    static const std::size_t frame_count = 16;
+
+    Sample interleaved[frame_count * channel_count];
+    Sample planar[channel_count][frame_count];
+    Sample *channels[channel_count];
+    Sample mixed[frame_count];
+    Sample mixed_planar[frame_count];
+
+    std::fill(std::begin(interleaved), std::end(interleaved), value);
+    for (std::size_t channel = 0; channel < channel_count; ++channel)
+        channels[channel] = planar[channel];
+
+    alsapp::deinterleave<channel_count>(interleaved, frame_count, channels);
+    alsapp::downmix<channel_count>(interleaved, frame_count, mixed);
+    alsapp::downmix_planar<channel_count>(channels, frame_count, mixed_planar);
+
+    return std::all_of(std::begin(mixed), std::end(mixed),
+                       [value](Sample sample) { return sample == value; })
+        && std::all_of(std::begin(mixed_planar), std::end(mixed_planar),
+                       [value](Sample sample) { return sample == value; });
+}
+
+static void
+check_channels()
+{
+    report("downmix 3 x int16 of -300",
+           downmixes_to<3>(static_cast<std::int16_t>(-300)));
+    report("downmix 6 x int32 of -3000",
+           downmixes_to<6>(static_cast<std::int32_t>(-3000)));
+    report("downmix 3 x float of -0.25", downmixes_to<3>(-0.25f));
+    report("downmix 2 x int16 of 300",
+           downmixes_to<2>(static_cast<std::int16_t>(300)));
+
+    typedef alsapp::MultichannelMicrophone<std::int32_t, 6> Array;
+
+    try {
+        Array interleaved("alsapp_null");
+        Array::interleaved_period_type period;
+        report("multichannel interleaved read",
+               interleaved.read(period) == Array::period_frame_size);
+
+        Array planar("alsapp_null", Array::Access::noninterleaved);
+        Array::planar_period_type channels;
+        report("multichannel planar read",
+               planar.read_planar(channels) == Array::period_frame_size);
+    } catch (const std::exception &error) {
+        report("open multichannel alsapp_null", false, error.what());
+    }
+}
+
+static_assert(!std::is_copy_constructible<Microphone>::value, "");
+static_assert(!std::is_copy_assignable<Microphone>::value, "");
+static_assert(std::is_nothrow_move_constructible<Microphone>::value, "");
+static_assert(std::is_nothrow_move_assignable<Microphone>::value, "");
+
+static void
+check_ownership()
+{
+    const std::size_t descriptors = open_descriptor_count();
+
+    {
+        Microphone::period_type period;
+        Microphone first("alsapp_null");
+        Microphone second(std::move(first));
+
+        report("moved-to microphone reads",
+               second.read(period) == sizeof(period));
+
+        Microphone third("alsapp_null");
+        third = std::move(second); // closes the device 'third' held
+
+        report("move-assigned microphone reads",
+               third.read(period) == sizeof(period));
+
+        std::vector<Microphone> microphones;
+        for (int i = 0; i < 8; ++i)
+            microphones.emplace_back("alsapp_null"); // moved on regrowth
+
+        std::thread reader([&] {
+            Microphone owned(std::move(microphones.back()));
+            Microphone::period_type period;
+            report("microphone handed to a thread reads",
+                   owned.read(period) == sizeof(period));
+        });
+        reader.join();
+    }
+
+    report("moves close every device exactly once",
+           open_descriptor_count() == descriptors);
+
+    const std::vector<std::string> names(16, "alsapp_null");
+    std::vector<Microphone> microphones = alsapp::open_microphones(names);
+
+    bool reading = microphones.size() == names.size();
+    for (Microphone &microphone : microphones) {
+        Microphone::period_type period;
+        reading &= microphone.read(period) == sizeof(period);
+    }
+    report("open_microphones opens every device", reading);
+
+    std::vector<std::string> mixed(names);
+    mixed[3] = "alsapp_missing";
+
+    std::vector<std::error_code> errors;
+    microphones = alsapp::open_microphones(mixed, errors);
+    report("open_microphones reports the failed device only",
+           !errors[0] && static_cast<bool>(errors[3]) && !errors[15]);
+
+    bool threw = false;
+    try {
+        microphones = alsapp::open_microphones(mixed);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    report("open_microphones throws for a failed device", threw);
+
+    microphones.clear();
+    report("open_microphones leaks no descriptors",
+           open_descriptor_count() == descriptors);
+}
+
+static void
+check_shutdown()
+{
+    const std::size_t descriptors = open_descriptor_count();
+
+    for (int i = 0; i < 200; ++i) {
+        Microphone microphone("alsapp_null");
+        Microphone::period_type period;
+        (void) microphone.read(period);
+    }
+
+    report("200 open/read/close cycles leak no descriptors",
+           open_descriptor_count() == descriptors);
+}
+
+static void
+stress(const char *const device,
+       const unsigned int microphone_count,
+       const unsigned int seconds)
+{
+    const std::size_t descriptors = open_descriptor_count();
+    const long start_kib = resident_kib();
+
+    std::atomic<std::uint64_t> period_total(0);
+    std::atomic<std::uint64_t> overrun_total(0);
+    std::atomic<std::uint64_t> failed(0);
+    std::vector<double> worst_usec(microphone_count, 0.0);
+    std::vector<std::thread> threads;
+
+    const Clock::time_point opening = Clock::now();
+    std::vector<std::error_code> errors;
+    std::vector<Microphone> microphones = alsapp::open_microphones(
+        std::vector<std::string>(microphone_count, device), errors
+    );
+    const double open_msec = std::chrono::duration<double, std::milli>(
+        Clock::now() - opening
+    ).count();
+    const Clock::time_point deadline = Clock::now()
+                                     + std::chrono::seconds(seconds);
+
+    for (unsigned int i = 0; i < microphone_count; ++i)
+        threads.emplace_back([&, i, microphone = std::move(microphones[i])]
+                             () mutable {
+            std::error_code error = errors[i];
+            Microphone::period_type periods[8];
+
+            while (!error && (Clock::now() < deadline)) {
+                const Clock::time_point before = Clock::now();
+                const std::size_t size = microphone.read(periods, error);
+                const double usec = std::chrono::duration<double, std::micro>(
+                    Clock::now() - before
+                ).count();
+
+                worst_usec[i] = std::max(worst_usec[i], usec);
+                period_total += size / sizeof(periods[0]);
+
+                if (error == std::errc::broken_pipe) {
+                    ++overrun_total;
+                    microphone.recover(error);
+                }
+            }
+
+            failed += static_cast<bool>(error);
+        });
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    const double worst = *std::max_element(worst_usec.begin(),
+                                           worst_usec.end());
+
+    std::cout << microphone_count << " microphones on " << device
+              << " opened in " << open_msec << "ms, ran for "
+              << seconds << "s: " << period_total << " periods ("
+              << (period_total / seconds) << "/s), worst read " << worst
+              << "us, " << overrun_total << " overruns, resident "
+              << start_kib << " -> " << resident_kib() << " KiB" << std::endl;
+
+    report("stress microphones ran without errors", failed == 0,
+           std::to_string(failed) + " failed");
+    report("stress leaks no descriptors",
+           open_descriptor_count() == descriptors);
+}
+
+int
+main(int argc,
+     char *argv[])
+{
+    bool stressing = false;
+    unsigned int microphone_count = 64;
+    unsigned int seconds = 10;
+    int argi = 1;
+
+    if ((argi < argc) && (std::strcmp(argv[argi], "--stress") == 0)) {
+        stressing = true;
+        ++argi;
+
+        if ((argi < argc) && (std::isdigit(argv[argi][0]) != 0))
+            microphone_count = std::strtoul(argv[argi++], nullptr, 10);
+        if ((argi < argc) && (std::isdigit(argv[argi][0]) != 0))
+            seconds = std::strtoul(argv[argi++], nullptr, 10);
+    }
+
+    const char *const device = (argi < argc) ? argv[argi] : "alsapp_null";
+
+    load_asoundrc(ASOUNDRC);
+
+    if (stressing) {
+        stress(device, (microphone_count > 0) ? microphone_count : 1,
+               (seconds > 0) ? seconds : 1);
+    } else {
+        check_construction();
+        check_reads();
+        check_channels();
+        check_file_contents();
+        check_batches();
+        check_overrun(device);
+        check_ownership();
+        check_shutdown();
+    }
+
+    std::cout << failure_count << " failed" << std::endl;
+
+    return failure_count != 0;
+}
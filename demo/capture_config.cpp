@@ -0,0 +1,90 @@
+#include "alsapp/capture_config.hpp"
+#include "alsapp/microphone.hpp"
+#include <cstdint>
+#include <iostream>
+
+
+// Capture configuration arithmetic, checked when this file compiles (the
+// program itself only prints what was checked).  Each 'must not compile'
+// case is built alone by 'make capture_config_fail', which fails unless the
+// compiler rejects it.
+
+typedef alsapp::Microphone::config_type Default;
+typedef alsapp::CaptureConfig<std::int32_t, 48000, 2, 256> Studio;
+typedef alsapp::CaptureConfig<float, 8000, 4, 64> Array;
+typedef alsapp::CaptureConfig<std::int16_t, 16000, 1, 160> Narrowband;
+
+// the shared format
+static_assert(Default::sample_format == SND_PCM_FORMAT_S16_LE, "");
+static_assert(Default::frame_size == 2, "");
+static_assert(Default::period_size == 256, "");
+static_assert(Default::byte_rate == 32000, "");
+static_assert(Default::period_usec == 8000, "");
+static_assert(sizeof(alsapp::Microphone::period_type) == Default::period_size,
+              "");
+
+// rounding up to whole periods
+static_assert(Default::periods_for_msec(0) == 0, "");
+static_assert(Default::periods_for_msec(1) == 1, "");
+static_assert(Default::periods_for_msec(8) == 1, "");
+static_assert(Default::periods_for_msec(9) == 2, "");
+static_assert(Default::periods_for_msec(500) == 63, "");
+static_assert(Default::periods_for_sec(1) == 125, "");
+static_assert(alsapp::Microphone::size_buffer_sec(3)
+              == alsapp::Microphone::size_buffer_msec(3000), "");
+
+// exact buffers
+static_assert(Default::is_whole_periods(1000), "");
+static_assert(!Default::is_whole_periods(500), "");
+static_assert(Default::Buffer<1000>::period_count == 125, "");
+static_assert(Default::Buffer<1000>::size == 32000, "");
+static_assert(sizeof(Default::Buffer<40>::type) == Default::Buffer<40>::size,
+              "");
+#ifdef MUST_NOT_COMPILE_PARTIAL_BUFFER
+Default::Buffer<500>::type half_second;
+#endif // ifdef MUST_NOT_COMPILE_PARTIAL_BUFFER
+
+// other formats
+static_assert(Studio::sample_format == SND_PCM_FORMAT_S32_LE, "");
+static_assert(Studio::period_size == 2048, "");
+static_assert(Studio::byte_rate == 384000, "");
+static_assert(Studio::period_usec == 5334, ""); // 5333.3 rounded up
+static_assert(Array::frame_size == 16, "");
+static_assert(Array::period_usec == 8000, "");
+// periods need not be a power of two, only the FFT stages require that
+static_assert(Narrowband::period_size == 320, "");
+static_assert(Narrowband::period_usec == 10000, "");
+static_assert(Narrowband::is_whole_periods(30), "");
+#ifdef MUST_NOT_COMPILE_NO_CHANNELS
+alsapp::CaptureConfig<std::int16_t, 16000, 0, 128>::Buffer<8>::type mute;
+#endif // ifdef MUST_NOT_COMPILE_NO_CHANNELS
+
+// latency budgets
+static_assert(alsapp::LatencyBudget<Default, 10000>::headroom_usec == 2000, "");
+static_assert(alsapp::LatencyBudget<Default, 40000, 5>::headroom_usec == 0, "");
+#ifdef MUST_NOT_COMPILE_OVER_BUDGET
+alsapp::LatencyBudget<Default, 20000, 3> three_periods;
+#endif // ifdef MUST_NOT_COMPILE_OVER_BUDGET
+
+template<typename Config>
+static void
+describe(const char *const name)
+{
+    std::cout << name << ": " << Config::channel_count << " x "
+              << (8 * sizeof(typename Config::sample_type)) << " bit @ "
+              << Config::sample_rate << " Hz, " << Config::period_frame_size
+              << " frames (" << Config::period_size << " bytes, "
+              << Config::period_usec << " us) per period, "
+              << Config::byte_rate << " bytes/s" << std::endl;
+}
+
+int
+main()
+{
+    describe<Default>("default");
+    describe<Studio>("studio");
+    describe<Array>("array");
+    describe<Narrowband>("narrowband");
+
+    return 0;
+}
@@ -17,7 +17,10 @@ main()
 {
     Microphone microphone;
 
-    Microphone::period_type buffer[Microphone::size_buffer(RECORD_SECONDS)];
+    // on the heap, a long recording would overflow the stack
+    alsapp::PeriodBuffer buffer(Microphone::size_buffer_msec(RECORD_SECONDS
+                                                             * 1000)
+                                * sizeof(Microphone::period_type));
 
     std::ofstream output(OUTPUT_FILE,
                          std::ofstream::binary);
@@ -25,7 +28,7 @@ main()
     std::size_t size_read =  microphone.read(buffer);
 
 
-    output.write(reinterpret_cast<char *>(&buffer[0]),
+    output.write(buffer.data(),
                  size_read);
 
     return 0;
@@ -0,0 +1,99 @@
+#include "alsapp/device_enumerator.hpp"
+#include "alsapp/hotplug_monitor.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+
+#ifndef WATCH_SECONDS
+#define WATCH_SECONDS 30
+#endif // #ifndef WATCH_SECONDS
+
+// an added card's PCMs are retried this often, waiting 50ms, 100ms, ...
+static const int rescan_attempts = 6;
+
+using alsapp::CaptureDeviceInfo;
+using alsapp::HotplugEvent;
+using alsapp::HotplugMonitor;
+
+static void
+print_devices(const std::vector<CaptureDeviceInfo> &devices)
+{
+    for (const CaptureDeviceInfo &device : devices) {
+        std::cout << "  " << device.name << "\n    " << device.description
+                  << std::endl;
+
+        if (!device.probed) {
+            std::cout << "    (busy or unavailable)" << std::endl;
+            continue;
+        }
+
+        std::cout << "    channels: " << device.min_channel_count << '-'
+                  << device.max_channel_count << ", rate: "
+                  << device.min_sample_rate << '-' << device.max_sample_rate
+                  << "Hz, formats:";
+
+        for (const snd_pcm_format_t format : device.sample_formats)
+            std::cout << ' ' << snd_pcm_format_name(format);
+
+        std::cout << std::endl;
+    }
+}
+
+// The kernel announces a card before udev creates (and grants access to) its
+// device nodes, so rescan with a backoff until one of its PCMs opens
+static void
+print_added_card(const int card)
+{
+    std::vector<CaptureDeviceInfo> devices;
+    std::chrono::milliseconds backoff(50);
+
+    for (int attempt = 1; ; ++attempt) {
+        devices = alsapp::list_capture_hardware();
+
+        const bool opened = std::any_of(
+            devices.begin(),
+            devices.end(),
+            [&](const CaptureDeviceInfo &device) {
+                return (device.card == card) && device.probed;
+            }
+        );
+        if (opened || (attempt == rescan_attempts))
+            break;
+
+        std::this_thread::sleep_for(backoff);
+        backoff *= 2;
+    }
+
+    print_devices(devices);
+}
+
+int
+main()
+{
+    // subscribe first so a card plugged in during the scan is not missed
+    HotplugMonitor monitor;
+
+    std::cout << "capture PCMs:" << std::endl;
+    print_devices(alsapp::list_capture_devices());
+
+    std::cout << "capture hardware:" << std::endl;
+    print_devices(alsapp::list_capture_hardware());
+
+    std::cout << "watching for " << WATCH_SECONDS << "s..." << std::endl;
+
+    HotplugEvent event;
+    while (monitor.wait(event, WATCH_SECONDS * 1000)) {
+        const bool added = (event.action == HotplugEvent::Action::added);
+
+        std::cout << "card " << event.card
+                  << (added ? " added" : " removed") << std::endl;
+
+        if (added)
+            print_added_card(event.card);
+    }
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include "alsapp/drift_resampler.hpp"
+#include "alsapp/microphone.hpp"
+#include "alsapp/speaker.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+
+// Plays one card's capture on another through a DriftResampler, reporting the
+// measured clock drift and the queue fill as it goes.  Without devices, the
+// two clocks are simulated instead: a producer running DRIFT_PPM fast (with
+// scheduling jitter) feeds a consumer for SIMULATED_SECONDS, faster than
+// real time, to show the fill level holding steady where a plain queue
+// would overflow.
+//
+// usage: drift_bridge [capture_device playback_device [seconds]]
+
+#ifndef DRIFT_PPM
+#define DRIFT_PPM 250.0
+#endif // #ifndef DRIFT_PPM
+
+#ifndef SIMULATED_SECONDS
+#define SIMULATED_SECONDS 3600
+#endif // #ifndef SIMULATED_SECONDS
+
+using alsapp::DriftResampler;
+
+typedef DriftResampler::period_type period_type;
+typedef DriftResampler::clock_type clock_type;
+
+static const double period_sec = 128.0 / 16000.0;
+
+static clock_type::time_point
+simulated_time(const double seconds)
+{
+    return clock_type::time_point(
+        std::chrono::nanoseconds(static_cast<std::int64_t>(seconds * 1e9))
+    );
+}
+
+static void
+simulate()
+{
+    static DriftResampler resampler;
+
+    const double producer_period_sec = period_sec / (1.0 + (DRIFT_PPM * 1e-6));
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> jitter_sec(0.0, 0.001);
+
+    period_type input;
+    period_type output;
+    std::uint64_t produced = 0;
+    std::uint64_t consumed = 0;
+    std::int16_t sample = 0;
+    std::size_t min_fill = SIZE_MAX;
+    std::size_t max_fill = 0;
+    double pull_nsec = 0.0;
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    double produce_jitter = jitter_sec(random);
+    double consume_jitter = jitter_sec(random);
+
+    // a period is pushed once captured, and pulled when its playback slot
+    // comes up, both a little late
+    for (;;) {
+        const double captured_at = (produced + 1) * producer_period_sec;
+        const double produce_at  = captured_at + produce_jitter;
+        const double consume_at  = (consumed * period_sec) + consume_jitter;
+
+        if (consume_at > SIMULATED_SECONDS)
+            break;
+
+        if (produce_at <= consume_at) {
+            for (std::size_t i = 0; i < sizeof(input); i += sizeof(sample)) {
+                sample = static_cast<std::int16_t>(sample + 97);
+                std::memcpy(&input[i], &sample, sizeof(sample));
+            }
+            (void) resampler.push(input, simulated_time(captured_at));
+            ++produced;
+            produce_jitter = jitter_sec(random);
+            continue;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        (void) resampler.pull(output, simulated_time(consume_at));
+        pull_nsec += std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+        ++consumed;
+        consume_jitter = jitter_sec(random);
+
+        // past the first loop time constants, the fill should hold
+        if (consume_at > 60.0) {
+            const std::size_t fill = resampler.fill_frame_size();
+            min_fill = (fill < min_fill) ? fill : min_fill;
+            max_fill = (fill > max_fill) ? fill : max_fill;
+        }
+
+        if ((consumed % 75000) == 0) // every 10 simulated minutes
+            std::cout << std::setw(6) << (consume_at / 60.0) << " min: drift "
+                      << resampler.drift_ppm() << " ppm, fill "
+                      << resampler.fill_frame_size() << " frames" << std::endl;
+    }
+
+    std::cout << "simulated " << DRIFT_PPM << " ppm for " << SIMULATED_SECONDS
+              << "s: fill " << min_fill << ".." << max_fill << " frames, "
+              << resampler.underrun_count() << " underruns, "
+              << resampler.overflow_count() << " overflows, pull "
+              << (pull_nsec / consumed) << " ns/period" << std::endl;
+}
+
+static void
+bridge(const char *const capture_name,
+       const char *const playback_name,
+       const unsigned int seconds)
+{
+    static DriftResampler resampler;
+
+    alsapp::Microphone microphone(capture_name);
+    alsapp::Speaker speaker(playback_name);
+    std::atomic_bool running(true);
+
+    std::thread capture([&] {
+        period_type periods[4];
+
+        while (running)
+            (void) resampler.push(periods,
+                                  microphone.read(periods) / sizeof(periods[0]));
+    });
+
+    period_type period;
+    const std::uint64_t period_count =
+        static_cast<std::uint64_t>(seconds / period_sec);
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    for (std::uint64_t i = 1; i <= period_count; ++i) {
+        (void) resampler.pull(period);
+        (void) speaker.write(period);
+
+        if ((i % 125) == 0)
+            std::cout << "drift " << std::setw(7) << resampler.drift_ppm()
+                      << " ppm, fill " << resampler.fill_frame_size()
+                      << " frames, " << resampler.underrun_count()
+                      << " underruns, " << resampler.overflow_count()
+                      << " overflows" << std::endl;
+    }
+
+    running = false;
+    capture.join();
+}
+
+int
+main(int argc,
+     char *argv[])
+{
+    if (argc < 3) {
+        simulate();
+        return 0;
+    }
+
+    bridge(argv[1], argv[2],
+           (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 60);
+
+    return 0;
+}
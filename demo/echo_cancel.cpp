@@ -0,0 +1,58 @@
+#include "alsapp/echo_canceller.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+
+
+// Offline echo cancellation of recorded raw S16_LE 16 kHz mono files, e.g.
+//
+//     ./echo_cancel microphone.raw reference.raw output.raw
+//
+// 'reference' must be time-aligned with 'microphone', a short reference is
+// padded with silence.
+
+typedef alsapp::EchoCanceller<> EchoCanceller;
+
+int
+main(int argc,
+     char *argv[])
+{
+    if (argc != 4) {
+        std::cerr << "usage: " << argv[0]
+                  << " <microphone.raw> <reference.raw> <output.raw>"
+                  << std::endl;
+        return 1;
+    }
+
+    std::ifstream microphone(argv[1], std::ifstream::binary);
+    std::ifstream reference(argv[2],  std::ifstream::binary);
+    std::ofstream output(argv[3],     std::ofstream::binary);
+
+    if (!microphone || !reference || !output) {
+        std::cerr << "failed to open input or output file" << std::endl;
+        return 1;
+    }
+
+    // too large for the stack
+    std::unique_ptr<EchoCanceller> canceller(new EchoCanceller);
+
+    EchoCanceller::period_type microphone_period;
+    EchoCanceller::period_type reference_period;
+
+    while (microphone.read(microphone_period, sizeof(microphone_period))) {
+        if (!reference.read(reference_period, sizeof(reference_period)))
+            std::fill(std::begin(reference_period),
+                      std::end(reference_period),
+                      0);
+
+        canceller->process(microphone_period,
+                           reference_period,
+                           microphone_period);
+
+        output.write(microphone_period, sizeof(microphone_period));
+    }
+
+    return 0;
+}
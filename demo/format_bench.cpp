@@ -0,0 +1,75 @@
+#include "alsapp/format_conversion.hpp"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+
+// Throughput of the sample format conversion kernels in ns per sample.
+
+#ifndef BENCH_SAMPLES
+#define BENCH_SAMPLES (1 << 24)
+#endif // #ifndef BENCH_SAMPLES
+
+template<typename Kernel>
+static void
+bench(const char *const name,
+      Kernel &&kernel)
+{
+    kernel(); // warm up
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::size_t clipped = kernel();
+    const double elapsed = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+
+    std::cout << name << ": " << (elapsed / BENCH_SAMPLES) << " ns/sample"
+              << " (clipped " << clipped << ")" << std::endl;
+}
+
+int
+main()
+{
+    const std::size_t count = BENCH_SAMPLES;
+
+    std::vector<std::int32_t> s32(count);
+    std::vector<std::uint8_t> s24_3(3 * count);
+    std::vector<std::int16_t> s16(count);
+    std::vector<float> f32(count);
+
+    for (std::size_t i = 0; i < count; ++i)
+        s32[i] = static_cast<std::int32_t>(i * 2654435761u);
+
+    alsapp::to_float(s32.data(), count, f32.data());
+    alsapp::float_to_s24_3le(f32.data(), count, s24_3.data());
+
+    alsapp::Dither dither;
+
+    bench("S32 -> S16", [&] {
+        return alsapp::narrow(s32.data(), count, s16.data());
+    });
+    bench("S32 -> S16 (TPDF)", [&] {
+        return alsapp::narrow(s32.data(), count, s16.data(), &dither);
+    });
+    bench("S32 -> float", [&] {
+        alsapp::to_float(s32.data(), count, f32.data());
+        return std::size_t(0);
+    });
+    bench("S24_3LE -> float", [&] {
+        alsapp::s24_3le_to_float(s24_3.data(), count, f32.data());
+        return std::size_t(0);
+    });
+    bench("float -> S16", [&] {
+        return alsapp::from_float(f32.data(), count, s16.data());
+    });
+    bench("float -> S16 (TPDF)", [&] {
+        return alsapp::from_float(f32.data(), count, s16.data(), &dither);
+    });
+    bench("S24_3LE -> S16", [&] {
+        return alsapp::convert_to_s16(s24_3.data(), SND_PCM_FORMAT_S24_3LE,
+                                      count, s16.data());
+    });
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "alsapp/level_meter.hpp"
+#include "alsapp/microphone.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+
+// Cost of LevelMeter::update() in ns per 128-frame period, then (given a
+// device name) live readings from that device, e.g. to spot a dead, quiet or
+// clipping microphone without recording it.
+//
+// usage: level_meter [device]
+
+#ifndef BENCH_PERIODS
+#define BENCH_PERIODS (1 << 20)
+#endif // #ifndef BENCH_PERIODS
+
+static void
+bench()
+{
+    typedef alsapp::Microphone::period_type period_type;
+
+    static const std::size_t period_count = 1024; // cycled, stays in cache
+
+    std::vector<period_type> periods(period_count);
+    std::int16_t sample = 0;
+    for (period_type &period : periods)
+        for (std::size_t i = 0; i < sizeof(period); i += sizeof(sample)) {
+            sample = static_cast<std::int16_t>(sample * 31821 + 13849);
+            std::memcpy(&period[i], &sample, sizeof(sample));
+        }
+
+    alsapp::LevelMeter meter;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < BENCH_PERIODS; ++i)
+        meter.update(&periods[i % period_count], 1);
+    const double elapsed = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+
+    const alsapp::LevelReading reading = meter.reading();
+
+    std::cout << "update: " << (elapsed / BENCH_PERIODS) << " ns/period ("
+              << reading.sequence << " readings, " << reading.clip_count
+              << " clipped)" << std::endl;
+}
+
+int
+main(int argc,
+     char *argv[])
+{
+    bench();
+
+    if (argc < 2)
+        return 0;
+
+    alsapp::Microphone microphone(argv[1]);
+    alsapp::LevelMeter meter;
+    alsapp::Microphone::period_type periods[16];
+    std::uint64_t shown = 0;
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    for (;;) {
+        meter.update(periods, microphone.read(periods) / sizeof(periods[0]));
+
+        const alsapp::LevelReading reading = meter.reading();
+        if (reading.sequence == shown)
+            continue;
+
+        shown = reading.sequence;
+
+        std::cout << "peak "    << std::setw(6) << reading.peak_dbfs
+                  << " dBFS  rms " << std::setw(6) << reading.rms_dbfs
+                  << " dBFS  floor " << std::setw(6)
+                  << reading.noise_floor_dbfs
+                  << " dBFS  dc " << std::setw(5)
+                  << (100.0f * reading.dc_offset)
+                  << "%  clipped " << reading.clip_count << std::endl;
+    }
+}
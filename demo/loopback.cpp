@@ -0,0 +1,32 @@
+#include "alsapp/duplex.hpp"
+#include <iostream>
+
+
+#ifndef LOOPBACK_SECONDS
+#define LOOPBACK_SECONDS 10
+#endif // #ifndef LOOPBACK_SECONDS
+
+using alsapp::Duplex;
+
+int
+main()
+{
+    Duplex duplex;
+
+    std::cout << "latency: " << duplex.latency_frame_size() << " frames ("
+              << duplex.latency_usec() << "us), period: "
+              << duplex.tuned_period_frame_size() << " frames" << std::endl;
+
+    unsigned long frames_left = LOOPBACK_SECONDS * 16000UL;
+
+    duplex.run([&](char *, snd_pcm_uframes_t frame_count) {
+        frames_left -= (frame_count < frames_left) ? frame_count : frames_left;
+        return frames_left > 0;
+    });
+
+    std::cout << "xruns: " << duplex.xrun_count() << ", latency: "
+              << duplex.latency_frame_size() << " frames ("
+              << duplex.latency_usec() << "us)" << std::endl;
+
+    return 0;
+}
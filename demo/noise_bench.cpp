@@ -0,0 +1,118 @@
+#include "alsapp/noise_suppressor.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+
+
+// Throughput of NoiseSuppressor on one core, reported as the number of
+// real-time 16 kHz streams that core could sustain.  Then checks that noise
+// is still suppressed after a stretch of digital silence (as a disconnected
+// ResilientMicrophone delivers), exiting non-zero if it is not.
+
+#ifndef BENCH_SECONDS
+#define BENCH_SECONDS 60
+#endif // #ifndef BENCH_SECONDS
+
+using alsapp::NoiseSuppressor;
+
+// attenuation (dB) of white noise in its second second, after 'silence_sec'
+static double
+noise_after_silence(const unsigned int silence_sec)
+{
+    std::unique_ptr<NoiseSuppressor> suppressor(new NoiseSuppressor);
+    std::mt19937 generator(2);
+    std::normal_distribution<float> noise(0.0f, 300.0f);
+
+    NoiseSuppressor::period_type period;
+    std::int16_t samples[128];
+    double input_power  = 0.0;
+    double output_power = 0.0;
+
+    const std::size_t silent_count = (silence_sec * 16000) / 128;
+    const std::size_t noise_count  = (2 * 16000) / 128;
+
+    for (std::size_t p = 0; p < silent_count + noise_count; ++p) {
+        const bool noisy = p >= silent_count;
+
+        for (std::size_t i = 0; i < 128; ++i)
+            samples[i] = noisy ? static_cast<std::int16_t>(noise(generator))
+                               : 0;
+
+        std::memcpy(period, samples, sizeof(period));
+        suppressor->process(period, period);
+
+        if (p < (silent_count + (noise_count / 2)))
+            continue;
+
+        for (std::size_t i = 0; i < 128; ++i) {
+            const double in = samples[i];
+            input_power += in * in;
+        }
+        std::memcpy(samples, period, sizeof(period));
+        for (std::size_t i = 0; i < 128; ++i) {
+            const double out = samples[i];
+            output_power += out * out;
+        }
+    }
+
+    return 10.0 * std::log10(input_power / output_power);
+}
+
+int
+main()
+{
+    const std::size_t period_count = (BENCH_SECONDS * 16000) / 128;
+
+    std::unique_ptr<NoiseSuppressor> suppressor(new NoiseSuppressor);
+
+    // tone in white noise, synthesized ahead so only suppression is timed
+    std::mt19937 generator(1);
+    std::normal_distribution<float> noise(0.0f, 1000.0f);
+
+    std::unique_ptr<NoiseSuppressor::period_type[]> input(
+        new NoiseSuppressor::period_type[period_count]
+    );
+    std::int16_t samples[128];
+
+    for (std::size_t p = 0; p < period_count; ++p) {
+        for (std::size_t i = 0; i < 128; ++i)
+            samples[i] = static_cast<std::int16_t>(
+                noise(generator) + (((p * 128 + i) % 32) < 16 ? 3000 : -3000)
+            );
+
+        std::memcpy(input[p], samples, sizeof(input[p]));
+    }
+
+    NoiseSuppressor::period_type period;
+    std::uint64_t checksum = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (std::size_t p = 0; p < period_count; ++p) {
+        suppressor->process(input[p], period);
+
+        checksum += static_cast<unsigned char>(period[0]);
+    }
+
+    const double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+
+    std::cout << period_count << " periods in " << elapsed << " s ("
+              << (elapsed * 1e9 / period_count) << " ns/period)\n"
+              << "streams per core: " << (BENCH_SECONDS / elapsed) << '\n'
+              << "checksum: " << checksum << std::endl;
+
+    // without any silence, the reference; after it, within a few dB of it
+    const double reference = noise_after_silence(0);
+    const double recovered = noise_after_silence(30);
+
+    std::cout << "noise attenuation: " << reference << " dB, after 30 s of "
+              << "silence " << recovered << " dB" << std::endl;
+
+    return (recovered < (reference - 3.0)) ? 1 : 0;
+}
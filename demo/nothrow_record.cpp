@@ -0,0 +1,63 @@
+// records like demo.cpp, built with -fno-exceptions
+#include "alsapp/microphone.hpp"
+#include <cstdio>
+#include <system_error>
+
+
+#ifndef OUTPUT_FILE
+#define OUTPUT_FILE    "output.raw"
+#endif // #ifndef OUTPUT_FILE
+
+#ifndef RECORD_SECONDS
+#define RECORD_SECONDS 3
+#endif // #ifndef RECORD_SECONDS
+
+using alsapp::Microphone;
+
+static Microphone::period_type
+buffer[Microphone::size_buffer_msec(RECORD_SECONDS * 1000)];
+
+int
+main()
+{
+    std::error_code error;
+
+    Microphone microphone("default", error);
+    if (error) {
+        std::fprintf(stderr, "open: %s\n", error.message().c_str());
+        return 1;
+    }
+
+    const std::size_t capacity = sizeof(buffer) / sizeof(buffer[0]);
+    std::size_t period = 0; // whole periods captured
+
+    while (period < capacity) {
+        const std::size_t size = microphone.read(&buffer[period],
+                                                 capacity - period,
+                                                 error);
+
+        if (error == std::errc::broken_pipe)
+            std::fprintf(stderr, "overrun at period %zu\n", period);
+
+        // the next read overwrites a trailing partial period
+        period += size / sizeof(buffer[0]);
+
+        microphone.recover(error);
+        if (error) {
+            std::fprintf(stderr, "read: %s\n", error.message().c_str());
+            return 1;
+        }
+    }
+
+    std::FILE *const output = std::fopen(OUTPUT_FILE, "wb");
+    if (output == nullptr)
+        return 1;
+
+    std::size_t size_read = period * sizeof(buffer[0]);
+    if (size_read > sizeof(buffer))
+        size_read = sizeof(buffer);
+
+    (void) std::fwrite(&buffer[0], 1, size_read, output);
+
+    return std::fclose(output) != 0;
+}
@@ -0,0 +1,210 @@
+#include "alsapp/noise_suppressor.hpp"
+#include "alsapp/pipeline.hpp"
+#include "alsapp/stage_registry.hpp"
+#include "alsapp/stages.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+// Runs a 24-stage compile-time Pipeline (with fan-out and voice activity
+// detection) and a StageRegistry-built DynamicPipeline over synthesized
+// audio, no sound card needed: alternating one second tone bursts and
+// background noise.  Prints the cost per period (and per stage), checks what
+// the stages saw and exits non-zero if anything failed.
+//
+// usage: pipeline [stage[:argument] ...]
+//
+// The stages given (default "gain:2.0 vad noise_suppression:0.2") are built
+// through the registry.
+
+#ifndef PIPELINE_SECONDS
+#define PIPELINE_SECONDS 20
+#endif // #ifndef PIPELINE_SECONDS
+
+using alsapp::period_type;
+
+typedef std::chrono::steady_clock Clock;
+
+static const std::size_t periods_per_sec = 16000 / 128;
+static const std::size_t period_count    = PIPELINE_SECONDS * periods_per_sec;
+
+static int failure_count = 0;
+
+static void
+report(const char *const check,
+       const bool passed,
+       const std::string &detail = std::string())
+{
+    std::cout << (passed ? "ok     " : "FAILED ") << check;
+    if (!detail.empty())
+        std::cout << " (" << detail << ')';
+    std::cout << std::endl;
+
+    failure_count += !passed;
+}
+
+// odd seconds hold a 440 Hz tone, all of them quiet noise
+static bool
+is_tone(const std::size_t period)
+{
+    return ((period / periods_per_sec) % 2) == 1;
+}
+
+static std::vector<period_type>
+synthesize()
+{
+    std::vector<period_type> periods(period_count);
+    std::mt19937 random(1);
+    std::normal_distribution<float> noise(0.0f, 30.0f);
+
+    for (std::size_t period = 0; period < period_count; ++period)
+        for (std::size_t frame = 0; frame < 128; ++frame) {
+            const float time = static_cast<float>((period * 128) + frame)
+                             / 16000.0f;
+            float value = noise(random);
+            if (is_tone(period))
+                value += 8000.0f * std::sin(2.0f * 3.14159265f * 440.0f * time);
+
+            const std::int16_t sample = static_cast<std::int16_t>(value);
+            std::memcpy(&periods[period][frame * sizeof(sample)],
+                        &sample,
+                        sizeof(sample));
+        }
+
+    return periods;
+}
+
+static void
+run_compiled(const std::vector<period_type> &input)
+{
+    using alsapp::Gain;
+
+    alsapp::VoiceActivity vad;
+    std::unique_ptr<alsapp::NoiseSuppressor> suppressor(
+        new alsapp::NoiseSuppressor
+    );
+    std::ostringstream file;
+    std::size_t sent = 0;
+
+    // 20 unity gains stand in for a long chain of cheap stages
+    auto pipeline = alsapp::make_pipeline(
+        Gain(1.0f), Gain(1.0f), Gain(1.0f), Gain(1.0f), Gain(1.0f),
+        Gain(1.0f), Gain(1.0f), Gain(1.0f), Gain(1.0f), Gain(1.0f),
+        Gain(1.0f), Gain(1.0f), Gain(1.0f), Gain(1.0f), Gain(1.0f),
+        Gain(1.0f), Gain(1.0f), Gain(1.0f), Gain(1.0f), Gain(1.0f),
+        std::ref(vad),
+        std::ref(*suppressor),
+        alsapp::fan_out(alsapp::FileTap(file),
+                        alsapp::make_pipeline(Gain(0.0f),
+                                              [&](period_type &period) {
+                                                  sent += period[0] == 0;
+                                              })),
+        Gain(1.0f)
+    );
+    decltype(pipeline)::timer_type timer;
+
+    std::size_t missed_tone = 0; // tone periods not flagged active
+    std::size_t held_noise  = 0; // noise periods active past the hangover
+    std::vector<period_type> periods(period_count);
+    std::memcpy(periods.data(),
+                input.data(),
+                period_count * sizeof(periods[0]));
+
+    const Clock::time_point start = Clock::now();
+    for (std::size_t i = 0; i < period_count; ++i) {
+        pipeline(periods[i], timer);
+
+        missed_tone += is_tone(i) && !vad.active();
+        held_noise  += !is_tone(i) && ((i % periods_per_sec) > 30)
+                    && vad.active();
+    }
+    const double nsec = std::chrono::duration<double, std::nano>(
+        Clock::now() - start
+    ).count() / period_count;
+
+    std::cout << pipeline.stage_count << " stage pipeline: " << nsec
+              << " ns/period (gain " << timer.average_nsec(0)
+              << ", vad " << timer.average_nsec(20)
+              << ", noise suppression " << timer.average_nsec(21)
+              << ", fan-out " << timer.average_nsec(22) << " ns)" << std::endl;
+
+    report("every stage ran every period",
+           timer.call_count(0) == period_count
+           && timer.call_count(pipeline.stage_count - 1) == period_count);
+    report("fan-out file tap got every period",
+           file.str().size() == period_count * sizeof(period_type));
+    report("fan-out branch got its own copy",
+           (sent == period_count)
+           && (std::memcmp(&file.str()[0], &periods[0],
+                           sizeof(period_type)) == 0));
+    report("vad flags every tone period", missed_tone == 0,
+           std::to_string(missed_tone) + " missed");
+    report("vad releases after the hangover", held_noise == 0,
+           std::to_string(held_noise) + " held");
+}
+
+static void
+run_registry(const std::vector<period_type> &input,
+             const std::vector<std::string> &specifications)
+{
+    alsapp::StageRegistry registry;
+    alsapp::DynamicPipeline pipeline = registry.build(specifications);
+    std::vector<period_type> periods(period_count);
+    std::memcpy(periods.data(),
+                input.data(),
+                period_count * sizeof(periods[0]));
+
+    const Clock::time_point start = Clock::now();
+    for (period_type &period : periods)
+        pipeline(period);
+    const double nsec = std::chrono::duration<double, std::nano>(
+        Clock::now() - start
+    ).count() / period_count;
+
+    std::cout << pipeline.stage_count() << " stage registry pipeline: "
+              << nsec << " ns/period" << std::endl;
+
+    for (const char *const malformed : { "gain:abc", "gain:2x", "vad:",
+                                         "noise_suppression:nan", "nope" }) {
+        bool threw = false;
+        try {
+            // "vad:" has an empty argument, which means the default
+            (void) registry.create(malformed);
+        } catch (const std::invalid_argument &) {
+            threw = true;
+        }
+
+        const bool expected = std::strcmp(malformed, "vad:") != 0;
+        report((std::string("registry ") + (expected ? "rejects " : "accepts ")
+                + malformed).c_str(),
+               threw == expected);
+    }
+}
+
+int
+main(int argc,
+     char *argv[])
+{
+    std::vector<std::string> specifications(argv + 1, argv + argc);
+    if (specifications.empty())
+        specifications = { "gain:2.0", "vad", "noise_suppression:0.2" };
+
+    const std::vector<period_type> input = synthesize();
+
+    run_compiled(input);
+    run_registry(input, specifications);
+
+    std::cout << failure_count << " failed" << std::endl;
+
+    return failure_count != 0;
+}
@@ -0,0 +1,52 @@
+// follow a ring_daemon, report throughput, level and losses every second
+#include "alsapp/shared_ring.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+
+#ifndef RING_SOCKET
+#define RING_SOCKET "/tmp/alsapp-ring.sock"
+#endif // #ifndef RING_SOCKET
+
+using alsapp::SharedRingReader;
+
+int
+main()
+{
+    SharedRingReader ring(RING_SOCKET);
+
+    SharedRingReader::Period period;
+    std::size_t period_count = 0;
+    double energy = 0.0;
+
+    while (ring.read(period, 1000)) {
+        const std::size_t sample_count = period.size / sizeof(std::int16_t);
+
+        for (std::size_t i = 0; i < sample_count; ++i) {
+            std::int16_t sample;
+            std::memcpy(&sample,
+                        period.data + (i * sizeof(sample)),
+                        sizeof(sample));
+            energy += static_cast<double>(sample) * sample;
+        }
+
+        if (!ring.valid(period))
+            std::cout << "period " << period.sequence
+                      << " overwritten while reading" << std::endl;
+
+        if (++period_count % 125 == 0) {
+            const double rms = std::sqrt(energy / (125.0 * sample_count));
+
+            std::cout << "period " << period.sequence << ", rms " << rms
+                      << ", backlog " << ring.backlog() << ", lost "
+                      << ring.lost_count() << std::endl;
+            energy = 0.0;
+        }
+    }
+
+    std::cout << "no periods for 1s, daemon stopped?" << std::endl;
+
+    return 0;
+}
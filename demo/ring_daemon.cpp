@@ -0,0 +1,31 @@
+// capture once, share with every ring_client on this host
+#include "alsapp/microphone.hpp"
+#include "alsapp/shared_ring.hpp"
+#include <iostream>
+
+
+#ifndef RING_SOCKET
+#define RING_SOCKET "/tmp/alsapp-ring.sock"
+#endif // #ifndef RING_SOCKET
+
+using alsapp::Microphone;
+using alsapp::SharedRingWriter;
+
+int
+main(int argc,
+     char *argv[])
+{
+    Microphone microphone((argc > 1) ? argv[1] : "default");
+
+    SharedRingWriter ring(RING_SOCKET);
+
+    std::cout << "sharing on " << RING_SOCKET << std::endl;
+
+    for (;;) {
+        ring.accept_clients();
+
+        // straight into the shared slot, no copy
+        (void) microphone.read(ring.claim());
+        ring.publish();
+    }
+}
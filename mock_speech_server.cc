@@ -0,0 +1,221 @@
+// Local stand-in for the Cloud Speech StreamingRecognize service, for
+// measuring streaming_transcribe and speech_load without a cloud account.
+//
+// usage: mock_speech_server [port] [latency_msec] [final_every]
+//
+// Every audio chunk is answered with an interim result 'latency_msec' after
+// it arrives (if the client asked for interim results), and every
+// 'final_every'th chunk with a final one.  Each stream's timing is printed
+// when it closes.
+#include <grpc++/grpc++.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "google/cloud/speech/v1/cloud_speech.grpc.pb.h"
+
+
+using google::cloud::speech::v1::Speech;
+using google::cloud::speech::v1::StreamingRecognizeRequest;
+using google::cloud::speech::v1::StreamingRecognizeResponse;
+
+typedef grpc::ServerReaderWriter<StreamingRecognizeResponse,
+                                 StreamingRecognizeRequest> ServerStream;
+typedef std::chrono::steady_clock Clock;
+
+
+// Writes scheduled responses when they come due, so reading audio is never
+// held up by the simulated recognition latency.
+class Responder
+{
+public:
+    explicit Responder(ServerStream *const stream)
+        : stream(stream),
+          closing(false),
+          thread(&Responder::run, this)
+    {}
+
+    void
+    schedule(const Clock::time_point due,
+             StreamingRecognizeResponse &&response)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.emplace_back(due, std::move(response));
+        }
+        ready.notify_one();
+    }
+
+    // send whatever is still pending, then stop
+    void
+    finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing = true;
+        }
+        ready.notify_one();
+        thread.join();
+    }
+
+
+private:
+    void
+    run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        for (;;) {
+            ready.wait(lock, [this] { return closing || !pending.empty(); });
+
+            if (pending.empty())
+                return;
+
+            const Clock::time_point due = pending.front().first;
+            if (ready.wait_until(lock, due) != std::cv_status::timeout
+                && (Clock::now() < due))
+                continue; // woken early, re-check
+
+            StreamingRecognizeResponse response =
+                std::move(pending.front().second);
+            pending.pop_front();
+
+            lock.unlock();
+            (void) stream->Write(response);
+            lock.lock();
+        }
+    }
+
+    ServerStream *const stream;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::pair<Clock::time_point,
+                         StreamingRecognizeResponse>> pending;
+    bool closing;
+    std::thread thread;
+}; // class Responder
+
+
+class MockSpeech final : public Speech::Service
+{
+public:
+    MockSpeech(const std::chrono::milliseconds latency,
+               const std::uint64_t final_every)
+        : latency(latency),
+          final_every(final_every),
+          stream_count(0)
+    {}
+
+    grpc::Status
+    StreamingRecognize(grpc::ServerContext *,
+                       ServerStream *stream) override
+    {
+        const std::uint64_t id = ++stream_count;
+
+        StreamingRecognizeRequest request;
+        if (!stream->Read(&request) || !request.has_streaming_config())
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                "first request must carry streaming_config");
+
+        const bool interim = request.streaming_config().interim_results();
+
+        const Clock::time_point start = Clock::now();
+        Clock::time_point first_audio;
+        std::uint64_t chunk_count = 0;
+        std::uint64_t byte_count  = 0;
+
+        Responder responder(stream);
+
+        while (stream->Read(&request)) {
+            const Clock::time_point now = Clock::now();
+
+            if (chunk_count++ == 0)
+                first_audio = now;
+
+            byte_count += request.audio_content().size();
+
+            const bool final = (chunk_count % final_every) == 0;
+            if (interim || final)
+                responder.schedule(now + latency,
+                                   result(chunk_count, final));
+        }
+
+        responder.finish();
+
+        const double seconds =
+            std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::cout << "stream " << id << ": " << chunk_count << " chunks, "
+                  << byte_count << " bytes in " << seconds << "s ("
+                  << (byte_count / (seconds > 0.0 ? seconds : 1.0))
+                  << " bytes/s)" << std::endl;
+
+        return grpc::Status::OK;
+    }
+
+
+private:
+    static StreamingRecognizeResponse
+    result(const std::uint64_t chunk,
+           const bool final)
+    {
+        StreamingRecognizeResponse response;
+
+        auto *const result = response.add_results();
+        result->set_is_final(final);
+        result->set_stability(final ? 1.0f : 0.5f);
+
+        auto *const alternative = result->add_alternatives();
+        alternative->set_transcript("chunk " + std::to_string(chunk));
+        alternative->set_confidence(final ? 0.9f : 0.0f);
+
+        return response;
+    }
+
+    const std::chrono::milliseconds latency;
+    const std::uint64_t final_every;
+    std::atomic<std::uint64_t> stream_count;
+}; // class MockSpeech
+
+
+int
+main(int argc,
+     char *argv[])
+{
+    const std::string port((argc > 1) ? argv[1] : "50051");
+    const long latency_msec = (argc > 2) ? std::strtol(argv[2], nullptr, 10)
+                                         : 200;
+    const long final_every  = (argc > 3) ? std::strtol(argv[3], nullptr, 10)
+                                         : 10;
+
+    MockSpeech service(std::chrono::milliseconds(latency_msec),
+                       (final_every > 0) ? final_every : 1);
+
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("0.0.0.0:" + port,
+                             grpc::InsecureServerCredentials());
+    builder.RegisterService(&service);
+
+    std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+    if (!server) {
+        std::cerr << "failed to listen on port " << port << std::endl;
+        return 1;
+    }
+
+    std::cout << "mock Speech listening on port " << port << ", "
+              << latency_msec << "ms latency, final every " << final_every
+              << " chunks" << std::endl;
+
+    server->Wait();
+
+    return 0;
+}
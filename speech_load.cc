@@ -0,0 +1,224 @@
+// Drive concurrent StreamingRecognize sessions against a Speech endpoint
+// (normally mock_speech_server) from a raw LINEAR16 16 kHz mono file, and
+// report first-result latency, throughput and CPU cost per stream.
+//
+// usage: speech_load [sessions] [audio_file] [address] [realtime|fast]
+#include <grpc++/grpc++.h>
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "google/cloud/speech/v1/cloud_speech.grpc.pb.h"
+
+
+using google::cloud::speech::v1::RecognitionConfig;
+using google::cloud::speech::v1::Speech;
+using google::cloud::speech::v1::StreamingRecognizeRequest;
+using google::cloud::speech::v1::StreamingRecognizeResponse;
+
+typedef std::chrono::steady_clock Clock;
+
+// 100ms of 16-bit, 16 kHz mono audio per request
+static const std::size_t chunk_size = 3200;
+static const std::chrono::milliseconds chunk_duration(100);
+
+struct SessionResult
+{
+    bool ok;
+    double first_result_msec; // < 0 if no result arrived
+    std::uint64_t bytes_sent;
+}; // struct SessionResult
+
+static SessionResult
+run_session(Speech::Stub &speech,
+            const std::string &audio,
+            const bool realtime)
+{
+    SessionResult outcome = { false, -1.0, 0 };
+
+    grpc::ClientContext context;
+    auto streamer = speech.StreamingRecognize(&context);
+
+    StreamingRecognizeRequest request;
+    auto *const streaming_config   = request.mutable_streaming_config();
+    auto *const recognition_config = streaming_config->mutable_config();
+
+    recognition_config->set_language_code("en");
+    recognition_config->set_sample_rate_hertz(16000);
+    recognition_config->set_encoding(RecognitionConfig::LINEAR16);
+    streaming_config->set_interim_results(true);
+
+    if (!streamer->Write(request))
+        return outcome;
+
+    // set by the writer, read by the reader: no result precedes the audio
+    std::atomic<Clock::rep> first_write(0);
+
+    // responses are read concurrently, as in streaming_transcribe
+    std::thread reader([&] {
+        StreamingRecognizeResponse response;
+
+        while (streamer->Read(&response))
+            if ((outcome.first_result_msec < 0.0)
+                && (response.results_size() > 0))
+                outcome.first_result_msec =
+                    std::chrono::duration<double, std::milli>(
+                        Clock::now() - Clock::time_point(Clock::duration(
+                            first_write.load(std::memory_order_acquire)
+                        ))
+                    ).count();
+    });
+
+    StreamingRecognizeRequest audio_request;
+    const Clock::time_point start = Clock::now();
+    std::size_t chunk = 0;
+
+    for (std::size_t offset = 0; offset < audio.size(); offset += chunk_size) {
+        const std::size_t size = std::min(chunk_size, audio.size() - offset);
+
+        if (realtime)
+            std::this_thread::sleep_until(start + (chunk * chunk_duration));
+
+        audio_request.set_audio_content(&audio[offset], size);
+
+        if (chunk++ == 0)
+            first_write.store(Clock::now().time_since_epoch().count(),
+                              std::memory_order_release);
+
+        if (!streamer->Write(audio_request))
+            break;
+
+        outcome.bytes_sent += size;
+    }
+
+    streamer->WritesDone();
+    reader.join();
+
+    outcome.ok = streamer->Finish().ok();
+
+    return outcome;
+}
+
+static double
+percentile(std::vector<double> &values,
+           const double fraction)
+{
+    if (values.empty())
+        return 0.0;
+
+    std::sort(values.begin(), values.end());
+
+    const std::size_t index =
+        static_cast<std::size_t>(fraction * (values.size() - 1) + 0.5);
+
+    return values[index];
+}
+
+static double
+cpu_seconds()
+{
+    rusage usage;
+    (void) getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_utime.tv_sec + (usage.ru_utime.tv_usec / 1e6)
+         + usage.ru_stime.tv_sec + (usage.ru_stime.tv_usec / 1e6);
+}
+
+int
+main(int argc,
+     char *argv[])
+{
+    long session_count = 8;
+
+    if (argc > 1) {
+        char *end;
+        errno = 0;
+        session_count = std::strtol(argv[1], &end, 10);
+
+        if ((end == argv[1]) || (*end != '\0') || (errno == ERANGE)
+            || (session_count < 1)) {
+            std::cerr << "invalid session count '" << argv[1] << "'\n\n"
+                      << "usage: speech_load [sessions] [audio_file] [address]"
+                         " [realtime|fast]\n"
+                      << "  sessions    concurrent streams, at least 1"
+                         " (default 8)" << std::endl;
+            return 2;
+        }
+    }
+
+    const char *const path     = (argc > 2) ? argv[2] : "demo/audio.raw";
+    const std::string address  = (argc > 3) ? argv[3] : "localhost:50051";
+    const bool realtime        = (argc <= 4) || (std::strcmp(argv[4], "fast")
+                                                 != 0);
+
+    std::ifstream file(path, std::ifstream::binary);
+    const std::string audio((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+    if (audio.empty()) {
+        std::cerr << "no audio in " << path << std::endl;
+        return 1;
+    }
+
+    auto channel = grpc::CreateChannel(address,
+                                       grpc::InsecureChannelCredentials());
+    std::unique_ptr<Speech::Stub> speech(Speech::NewStub(channel));
+
+    std::vector<SessionResult> results(session_count);
+    std::vector<std::thread> sessions;
+
+    const double cpu_start = cpu_seconds();
+    const Clock::time_point start = Clock::now();
+
+    for (long i = 0; i < session_count; ++i)
+        sessions.emplace_back([&, i] {
+            results[i] = run_session(*speech, audio, realtime);
+        });
+
+    for (std::thread &session : sessions)
+        session.join();
+
+    const double wall = std::chrono::duration<double>(Clock::now()
+                                                      - start).count();
+    const double cpu  = cpu_seconds() - cpu_start;
+
+    std::vector<double> latencies;
+    std::uint64_t bytes_sent = 0;
+    long failed = 0;
+
+    for (const SessionResult &result : results) {
+        bytes_sent += result.bytes_sent;
+        failed     += !result.ok;
+
+        if (result.first_result_msec >= 0.0)
+            latencies.push_back(result.first_result_msec);
+    }
+
+    std::cout << "sessions:            " << session_count << " ("
+              << failed << " failed, " << (realtime ? "realtime" : "fast")
+              << ")\n"
+              << "wall time:           " << wall << "s\n"
+              << "client cpu time:     " << cpu << "s\n"
+              << "streams per core:    "
+              << ((cpu > 0.0) ? (session_count * wall / cpu) : 0.0) << '\n'
+              << "throughput:          " << (bytes_sent / wall)
+              << " bytes/s\n"
+              << "first result p50:    " << percentile(latencies, 0.50)
+              << "ms\n"
+              << "first result p99:    " << percentile(latencies, 0.99)
+              << "ms" << std::endl;
+
+    return failed != 0;
+}
@@ -13,14 +13,30 @@
 // limitations under the License.
 #include <grpc++/grpc++.h>
 
+#include <pthread.h>
+#include <sched.h>
+
+#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
 
 #include "google/cloud/speech/v1/cloud_speech.grpc.pb.h"
+#include "alsapp/level_meter.hpp"
 #include "alsapp/microphone.hpp"
+#include "alsapp/resilient_microphone.hpp"
+#include "alsapp/trace.hpp"
+#include "transcribe_options.hpp"
+#include "transcript_assembler.hpp"
 
 
 using google::cloud::speech::v1::RecognitionConfig;
@@ -28,59 +44,267 @@ using google::cloud::speech::v1::Speech;
 using google::cloud::speech::v1::StreamingRecognizeRequest;
 using google::cloud::speech::v1::StreamingRecognizeResponse;
 
+using alsapp::LevelMeter;
+using alsapp::LevelReading;
 using alsapp::Microphone;
+using alsapp::ResilientMicrophone;
+using alsapp::Tracer;
+
+typedef std::chrono::steady_clock Clock;
+
+
+// Shutdown (stop word, SIGINT, SIGTERM or the service ending the stream)
+// stops capture at once, sends what the device still buffered, closes the
+// send side and waits up to drain_timeout_msec for final results before
+// cancelling the call.  Each step is timed from the request.
+struct Drain
+{
+    std::mutex mutex;
+    std::condition_variable done;
+    bool responses_done = false;
+    bool timed_out      = false;
+    Clock::time_point capture_stopped;
+    Clock::time_point writes_done;
+    Clock::time_point responses_ended;
+}; // struct Drain
+
+static Drain drain;
+
+// set before shutdown can be requested
+static ResilientMicrophone *active_microphone = nullptr;
+
+// Clock time since epoch, 0 until requested
+static std::atomic<Clock::rep> shutdown_requested(0);
+
+// callable from signal handlers
+static void
+request_shutdown()
+{
+    Clock::rep unrequested = 0;
 
+    if (shutdown_requested.compare_exchange_strong(
+            unrequested,
+            Clock::now().time_since_epoch().count()
+        ))
+        active_microphone->stop();
+}
 
-static std::atomic_bool microphone_on(true);
-static std::string stop_word("stop");
+static void
+shutdown_on_signal(int)
+{
+    request_shutdown();
+}
 
-// Write the audo in 1 second chunks
+static void
+report_shutdown()
+{
+    // the call can end on its own (a failed write) before any request,
+    // timings then count from the end of capture
+    Clock::time_point started(Clock::duration(shutdown_requested.load()));
+    const bool unrequested = drain.capture_stopped < started;
+
+    if (unrequested)
+        started = drain.capture_stopped;
+
+    const auto since_start = [&](const Clock::time_point time) {
+        return std::chrono::duration<double, std::milli>(time
+                                                         - started).count();
+    };
+
+    std::cerr << "Shutdown: ";
+    if (unrequested)
+        std::cerr << "capture ended by the stream, ";
+    else
+        std::cerr << "capture drained after "
+                  << since_start(drain.capture_stopped) << "ms, ";
+
+    std::cerr << "writes done after " << since_start(drain.writes_done)
+              << "ms, final results after "
+              << since_start(drain.responses_ended) << "ms"
+              << (drain.timed_out ? " (drain timed out, call cancelled)" : "")
+              << std::endl;
+}
+
+// chunks written to the stream so far, a response covers all of them
+static std::atomic<std::uint64_t> sent_chunk_count(0);
+
+// Report capture interruptions, the stream stays open through them
+static void
+report_gap(const ResilientMicrophone::Gap &gap)
+{
+    static const char *const causes[] = { "overrun", "suspend", "disconnect" };
+
+    const auto duration =
+        std::chrono::duration_cast<std::chrono::milliseconds>(gap.end
+                                                              - gap.start);
+
+    std::cerr << "Capture gap (" << causes[static_cast<int>(gap.cause)]
+              << "): " << duration.count() << "ms, "
+              << gap.silence_frame_count << " frames of silence sent."
+              << std::endl;
+}
+
+// Pin 'thread' to 'cpu' and raise it to SCHED_FIFO 'priority' where asked.
+// Failures (usually EPERM for priorities) are reported, not fatal.
+static void
+place_thread(const pthread_t thread,
+             const char *const name,
+             const int cpu,
+             const int priority)
+{
+    if (cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+
+        const int status = pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+        if (status != 0)
+            std::cerr << "Failed to pin " << name << " thread to CPU " << cpu
+                      << ": " << std::strerror(status) << std::endl;
+    }
+
+    if (priority > 0) {
+        sched_param parameters = {};
+        parameters.sched_priority = priority;
+
+        const int status = pthread_setschedparam(thread,
+                                                 SCHED_FIFO,
+                                                 &parameters);
+        if (status != 0)
+            std::cerr << "Failed to set " << name << " thread priority "
+                      << priority << ": " << std::strerror(status)
+                      << std::endl;
+    }
+}
+
+// Write the audio in 'chunk_msec' chunks until the microphone is stopped
+// and drained, then close the send side and give the service until the
+// drain deadline to answer
 static void
 microphone_main(
     grpc::ClientReaderWriterInterface<StreamingRecognizeRequest,
-                                      StreamingRecognizeResponse> *streamer
+                                      StreamingRecognizeResponse> *streamer,
+    ResilientMicrophone &microphone,
+    grpc::ClientContext &context,
+    const TranscribeOptions &options,
+    Tracer &tracer
 )
 {
     StreamingRecognizeRequest request;
-    Microphone::period_type buffer[Microphone::size_buffer_msec(500)];
 
-    std::cout << "sizeof(buffer): " << sizeof(buffer) << std::endl;
+    const std::size_t capacity =
+        Microphone::size_buffer_msec(options.chunk_msec);
+    const std::unique_ptr<ResilientMicrophone::period_type[]> buffer(
+        new ResilientMicrophone::period_type[capacity]
+    );
+
+    std::cout << "chunk size: "
+              << capacity * sizeof(ResilientMicrophone::period_type)
+              << " bytes" << std::endl;
 
     std::size_t size_read;
 
-    Microphone microphone;
+    LevelMeter meter;
+
+    std::uint64_t chunk = 0;
 
-    do {
-        size_read = microphone.read(buffer);
+    while ((size_read = microphone.read(buffer.get(), capacity)) > 0) {
+        tracer.record(Tracer::Stage::capture, chunk);
+
+        meter.update(reinterpret_cast<const std::int16_t *>(&buffer[0][0]),
+                     size_read / sizeof(std::int16_t));
 
         // And write the chunk to the stream.
         request.set_audio_content(&buffer[0],
                                   size_read);
+        tracer.record(Tracer::Stage::enqueue, chunk);
+
+        const LevelReading level = meter.reading();
+
+        std::cout << "Sending " << size_read / 1024 << "k bytes (peak "
+                  << level.peak_dbfs << " dBFS, rms " << level.rms_dbfs
+                  << " dBFS, floor " << level.noise_floor_dbfs << " dBFS, "
+                  << level.clip_count << " clipped)." << std::endl;
 
-        std::cout << "Sending " << size_read / 1024 << "k bytes." << std::endl;
+        if (!streamer->Write(request))
+            break; // the call is over
+
+        tracer.record(Tracer::Stage::send, chunk);
+        sent_chunk_count = ++chunk;
+    }
 
-        streamer->Write(request);
-    } while (microphone_on);
+    const Clock::time_point capture_stopped = Clock::now();
 
     streamer->WritesDone();
+
+    std::unique_lock<std::mutex> lock(drain.mutex);
+
+    drain.capture_stopped = capture_stopped;
+    drain.writes_done     = Clock::now();
+
+    if (!drain.done.wait_for(
+            lock,
+            std::chrono::milliseconds(options.drain_timeout_msec),
+            [] { return drain.responses_done; }
+        )) {
+        drain.timed_out = true;
+        context.TryCancel();
+    }
 }
 
 int
-main()
+main(int argc,
+     char *argv[])
 {
+    TranscribeOptions options;
+    std::string error;
+
+    if (!options.parse_arguments(argc, argv, error)) {
+        if (!error.empty())
+            std::cerr << error << "\n\n";
+
+        std::cerr << TranscribeOptions::usage();
+        return error.empty() ? 0 : 2;
+    }
+
+    options.print(std::cout, Microphone::sample_rate);
+
+    Tracer tracer(options.trace_sample_interval);
+
+    // SIGUSR1 dumps are written here, never on the capture thread
+    std::atomic_bool tracing(tracer.enabled());
+    std::thread dump_thread;
+
+    if (tracer.enabled()) {
+        Tracer::dump_on_signal(SIGUSR1);
+
+        dump_thread = std::thread([&] {
+            while (tracing) {
+                if (Tracer::dump_requested())
+                    (void) tracer.dump(options.trace_output.c_str());
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        });
+    }
+
     StreamingRecognizeRequest request;
 
     // configure audio format
     auto *streaming_config   = request.mutable_streaming_config();
     auto *recognition_config = streaming_config->mutable_config();
 
-    recognition_config->set_language_code("en");
-    recognition_config->set_sample_rate_hertz(16000);
+    recognition_config->set_language_code(options.language);
+    recognition_config->set_sample_rate_hertz(Microphone::sample_rate);
     recognition_config->set_encoding(RecognitionConfig::LINEAR16);
+    recognition_config->set_max_alternatives(options.max_alternatives);
 
     // Create a Speech Stub connected to the speech service.
-    auto channel = grpc::CreateChannel("speech.googleapis.com",
-                                       grpc::GoogleDefaultCredentials());
+    auto channel = grpc::CreateChannel(
+        options.endpoint,
+        options.insecure ? grpc::InsecureChannelCredentials()
+                         : grpc::GoogleDefaultCredentials()
+    );
     std::unique_ptr<Speech::Stub> speech(Speech::NewStub(channel));
 
     // Begin a stream.
@@ -88,38 +312,91 @@ main()
     auto streamer = speech->StreamingRecognize(&context);
 
     // Write the first request, containing the config only.
-    streaming_config->set_interim_results(true);
+    streaming_config->set_interim_results(options.interim_results);
     streamer->Write(request);
 
+    ResilientMicrophone microphone(options.device.c_str(), &report_gap);
+
+    active_microphone = &microphone;
+    std::signal(SIGINT, &shutdown_on_signal);
+    std::signal(SIGTERM, &shutdown_on_signal);
+
     // The microphone thread writes the audio content.
     std::thread microphone_thread(&microphone_main,
-                                  streamer.get());
+                                  streamer.get(),
+                                  std::ref(microphone),
+                                  std::ref(context),
+                                  std::cref(options),
+                                  std::ref(tracer));
+
+    place_thread(microphone_thread.native_handle(),
+                 "capture",
+                 options.capture_cpu,
+                 options.capture_priority);
+    place_thread(pthread_self(), "response", options.response_cpu, 0);
+
+    // Print only what changed: committed text once, and the part of the
+    // tentative tail that was revised.
+    TranscriptAssembler assembler([&](const TranscriptDelta &delta) {
+        if (delta.kind == TranscriptDelta::Kind::final) {
+            std::cout << "final:   " << delta.text << '\n';
+
+            if (delta.text.find(options.stop_word) != std::string_view::npos)
+                request_shutdown();
+        } else {
+            std::cout << "interim: [" << delta.retained << "] " << delta.text
+                      << " (stability " << delta.stability << ")\n";
+        }
+    }, options.min_stability);
 
     // Read responses.
     StreamingRecognizeResponse response;
+    std::uint64_t responded_chunk_count = 0;
     while (streamer->Read(&response)) {  // Returns false when no more to read.
-        // Dump the transcript of all the results.
-        for (int r = 0; r < response.results_size(); ++r) {
-            auto result = response.results(r);
-
-            std::cout << "Result stability: " << result.stability() << std::endl;
-
-            for (int a = 0; a < result.alternatives_size(); ++a) {
-                auto alternative = result.alternatives(a);
+        // end each traced chunk's slice once, at the first result after it
+        // was sent
+        const std::uint64_t sent = sent_chunk_count;
+        for (; (response.results_size() > 0) && (responded_chunk_count < sent);
+             ++responded_chunk_count)
+            tracer.record(Tracer::Stage::response,
+                          responded_chunk_count,
+                          response.results(0).stability());
+
+        assembler.consume(response);
+
+        if (assembler.tail().find(options.stop_word) != std::string::npos)
+            request_shutdown();
+    }
 
-                std::cout << alternative.confidence() << '\t'
-                          << alternative.transcript() << std::endl;
+    // no-op unless the service ended the stream first
+    request_shutdown();
 
-                if (alternative.transcript().find(stop_word) != std::string::npos)
-                    microphone_on = false;
-            }
-        }
+    {
+        std::lock_guard<std::mutex> lock(drain.mutex);
+        drain.responses_done  = true;
+        drain.responses_ended = Clock::now();
     }
+    drain.done.notify_one();
+
+    std::cout.flush();
 
     grpc::Status status = streamer->Finish();
 
     microphone_thread.join();
 
+    // stop() must not reach a destroyed microphone
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+
+    report_shutdown();
+
+    if (tracer.enabled()) {
+        tracing = false;
+        dump_thread.join();
+
+        (void) tracer.dump(options.trace_output.c_str());
+    }
+
     const int exit_status = !status.ok();
 
     if (exit_status)
@@ -0,0 +1,342 @@
+#ifndef TRANSCRIBE_OPTIONS_HPP
+#define TRANSCRIBE_OPTIONS_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include <algorithm>   // std::find
+#include <cerrno>      // errno, ERANGE
+#include <climits>     // PATH_MAX
+#include <cstdint>     // std::uint64_t
+#include <cstdlib>     // std::getenv, std::strto[ll|ull|f|d], ::realpath
+#include <fstream>     // std::ifstream
+#include <istream>     // std::istream
+#include <ostream>     // std::ostream
+#include <string>      // std::string, std::getline
+#include <type_traits> // std::is_signed
+#include <vector>      // std::vector
+
+
+
+// EXTERNAL API
+// =============================================================================
+
+// Run-time settings of streaming_transcribe.  Each can be given on the
+// command line as '--name value' or '--name=value', or in a config file
+// ('--config path') as 'name = value' lines ('#' starts a comment).  Later
+// settings override earlier ones, so the command line can override a file
+// given before it.
+struct TranscribeOptions
+{
+    // Capture
+    // -------------------------------------------------------------------------
+    std::string device       = "default";
+    unsigned long chunk_msec = 500; // audio per request
+
+    // Recognition
+    // -------------------------------------------------------------------------
+    std::string endpoint  = "speech.googleapis.com";
+    bool insecure         = false; // plaintext, e.g. mock_speech_server
+    std::string language  = "en";
+    long max_alternatives = 1;
+    bool interim_results  = true;
+    float min_stability   = 0.0f; // interim results below are held back
+    std::string stop_word = "stop";
+
+    // after the last audio, wait this long for final results (a minute at
+    // most, the stream is closed by then)
+    static const unsigned long max_drain_timeout_msec = 60000;
+    unsigned long drain_timeout_msec = 2000;
+
+    // Threads
+    // -------------------------------------------------------------------------
+    int capture_cpu      = -1; // pin to this CPU, -1 leaves it unpinned
+    int response_cpu     = -1;
+    int capture_priority = 0;  // SCHED_FIFO priority, 0 keeps SCHED_OTHER
+
+    // Tracing
+    // -------------------------------------------------------------------------
+    // trace every Nth chunk (0 disables), dumped on SIGUSR1 and at exit;
+    // default to the TRACE_SAMPLE_INTERVAL and TRACE_OUTPUT variables
+    std::uint64_t trace_sample_interval =
+        (std::getenv("TRACE_SAMPLE_INTERVAL") != nullptr)
+        ? std::strtoull(std::getenv("TRACE_SAMPLE_INTERVAL"), nullptr, 10)
+        : 0;
+    std::string trace_output =
+        (std::getenv("TRACE_OUTPUT") != nullptr) ? std::getenv("TRACE_OUTPUT")
+                                                 : "trace.json";
+
+    // set one option, false (with a reason) if unknown or malformed
+    bool
+    set(const std::string &name,
+        const std::string &value,
+        std::string &error)
+    {
+        bool valid;
+
+        if (name == "device")
+            valid = !(device = value).empty();
+        else if (name == "chunk_msec")
+            valid = parse(value, chunk_msec) && (chunk_msec > 0);
+        else if (name == "endpoint")
+            valid = !(endpoint = value).empty();
+        else if (name == "insecure")
+            valid = parse(value, insecure);
+        else if (name == "language")
+            valid = !(language = value).empty();
+        else if (name == "max_alternatives")
+            valid = parse(value, max_alternatives)
+                 && (max_alternatives >= 1) && (max_alternatives <= 30);
+        else if (name == "interim_results")
+            valid = parse(value, interim_results);
+        else if (name == "min_stability")
+            valid = parse(value, min_stability)
+                 && (min_stability >= 0.0f) && (min_stability <= 1.0f);
+        else if (name == "stop_word")
+            valid = !(stop_word = value).empty();
+        else if (name == "drain_timeout_msec")
+            valid = parse(value, drain_timeout_msec)
+                 && (drain_timeout_msec <= max_drain_timeout_msec);
+        else if (name == "capture_cpu")
+            valid = parse(value, capture_cpu) && (capture_cpu >= -1);
+        else if (name == "response_cpu")
+            valid = parse(value, response_cpu) && (response_cpu >= -1);
+        else if (name == "capture_priority")
+            valid = parse(value, capture_priority)
+                 && (capture_priority >= 0) && (capture_priority <= 99);
+        else if (name == "trace_sample_interval")
+            valid = parse(value, trace_sample_interval);
+        else if (name == "trace_output")
+            valid = !(trace_output = value).empty();
+        else if (name == "config")
+            return load(value, error);
+        else {
+            error = "unknown option '" + name + "'";
+            return false;
+        }
+
+        if (!valid)
+            error = "invalid value '" + value + "' for '" + name + "'";
+
+        return valid;
+    }
+
+    // apply a config file, which may name others but not itself (directly
+    // or through them)
+    bool
+    load(const std::string &path,
+         std::string &error)
+    {
+        std::ifstream file(path);
+        if (!file) {
+            error = "failed to open config file '" + path + "'";
+            return false;
+        }
+
+        char resolved[PATH_MAX];
+        const std::string identity =
+            (::realpath(path.c_str(), resolved) != nullptr) ? resolved : path;
+
+        if (std::find(loading.begin(), loading.end(), identity)
+            != loading.end()) {
+            error = "config file '" + path + "' includes itself";
+            return false;
+        }
+
+        loading.push_back(identity);
+        const bool applied = apply(file, path, error);
+        loading.pop_back();
+
+        return applied;
+    }
+
+    // apply command line arguments, false on '--help' or an error
+    bool
+    parse_arguments(const int argc,
+                    char *const argv[],
+                    std::string &error)
+    {
+        for (int i = 1; i < argc; ++i) {
+            std::string argument(argv[i]);
+
+            if (argument.compare(0, 2, "--") != 0) {
+                error = "unexpected argument '" + argument + "'";
+                return false;
+            }
+            argument.erase(0, 2);
+
+            if (argument == "help")
+                return false;
+
+            std::string value;
+            const std::size_t equals = argument.find('=');
+
+            if (equals != std::string::npos) {
+                value = argument.substr(equals + 1);
+                argument.erase(equals);
+            } else if (++i < argc) {
+                value = argv[i];
+            } else {
+                error = "missing value for '--" + argument + "'";
+                return false;
+            }
+
+            // accept --stop-word as well as --stop_word
+            for (char &c : argument)
+                c = (c == '-') ? '_' : c;
+
+            if (!set(argument, value, error))
+                return false;
+        }
+
+        return true;
+    }
+
+    // the effective settings, in config file syntax
+    void
+    print(std::ostream &output,
+          const unsigned int sample_rate) const
+    {
+        output << "# streaming_transcribe settings\n"
+               << "device                = " << device << '\n'
+               << "chunk_msec            = " << chunk_msec << '\n'
+               << "endpoint              = " << endpoint << '\n'
+               << "insecure              = " << insecure << '\n'
+               << "language              = " << language << '\n'
+               << "max_alternatives      = " << max_alternatives << '\n'
+               << "interim_results       = " << interim_results << '\n'
+               << "min_stability         = " << min_stability << '\n'
+               << "stop_word             = " << stop_word << '\n'
+               << "drain_timeout_msec    = " << drain_timeout_msec << '\n'
+               << "capture_cpu           = " << capture_cpu << '\n'
+               << "response_cpu          = " << response_cpu << '\n'
+               << "capture_priority      = " << capture_priority << '\n'
+               << "trace_sample_interval = " << trace_sample_interval << '\n'
+               << "trace_output          = " << trace_output << '\n'
+               << "# fixed by the capture format\n"
+               << "# encoding            = LINEAR16\n"
+               << "# sample_rate         = " << sample_rate << '\n';
+    }
+
+    static const char *
+    usage()
+    {
+        return
+            "usage: streaming_transcribe [--config FILE] [--NAME VALUE]...\n"
+            "\n"
+            "  --config FILE                 read 'NAME = VALUE' lines\n"
+            "  --device NAME                 ALSA capture device\n"
+            "  --chunk_msec N                audio per request\n"
+            "  --endpoint HOST[:PORT]        Speech service address\n"
+            "  --insecure 0|1                plaintext channel, no credentials\n"
+            "  --language CODE               BCP-47 language code\n"
+            "  --max_alternatives N          1 to 30\n"
+            "  --interim_results 0|1         request interim results\n"
+            "  --min_stability X             hide interim results below X\n"
+            "  --stop_word WORD              stop capturing once heard\n"
+            "  --drain_timeout_msec N        wait at exit, 0 to 60000\n"
+            "  --capture_cpu N               pin the capture thread, -1 off\n"
+            "  --response_cpu N              pin the response thread, -1 off\n"
+            "  --capture_priority N          SCHED_FIFO priority, 0 off\n"
+            "  --trace_sample_interval N     trace every Nth chunk, 0 off\n"
+            "  --trace_output PATH           trace file (SIGUSR1 and exit)\n";
+    }
+
+    // Value Parsing
+    // -------------------------------------------------------------------------
+    // strict conversions, false unless all of 'text' is a value in range
+    // (also used by batch_transcribe)
+    static bool
+    parse(const std::string &text,
+          bool &value)
+    {
+        if ((text == "1") || (text == "true") || (text == "yes"))
+            value = true;
+        else if ((text == "0") || (text == "false") || (text == "no"))
+            value = false;
+        else
+            return false;
+
+        return true;
+    }
+
+    template<typename Integer>
+    static bool
+    parse(const std::string &text,
+          Integer &value)
+    {
+        char *end;
+        errno = 0;
+        const long long parsed = std::strtoll(text.c_str(), &end, 10);
+
+        value = static_cast<Integer>(parsed);
+
+        return !text.empty() && (*end == '\0') && (errno != ERANGE)
+            && ((parsed >= 0) || std::is_signed<Integer>::value)
+            && (static_cast<long long>(value) == parsed);
+    }
+
+    static bool
+    parse(const std::string &text,
+          float &value)
+    {
+        char *end;
+        value = std::strtof(text.c_str(), &end);
+
+        return !text.empty() && (*end == '\0');
+    }
+
+    static bool
+    parse(const std::string &text,
+          double &value)
+    {
+        char *end;
+        value = std::strtod(text.c_str(), &end);
+
+        return !text.empty() && (*end == '\0');
+    }
+
+
+private:
+    // apply 'name = value' lines
+    bool
+    apply(std::istream &file,
+          const std::string &path,
+          std::string &error)
+    {
+        std::string line;
+        for (unsigned int number = 1; std::getline(file, line); ++number) {
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty())
+                continue;
+
+            const std::size_t equals = line.find('=');
+            if ((equals == std::string::npos)
+                || !set(trim(line.substr(0, equals)),
+                        trim(line.substr(equals + 1)),
+                        error)) {
+                error = path + ":" + std::to_string(number) + ": "
+                      + ((equals == std::string::npos)
+                         ? std::string("expected 'name = value'")
+                         : error);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static std::string
+    trim(const std::string &text)
+    {
+        static const char blanks[] = " \t\r\n";
+
+        const std::size_t first = text.find_first_not_of(blanks);
+        if (first == std::string::npos)
+            return std::string();
+
+        return text.substr(first, text.find_last_not_of(blanks) - first + 1);
+    }
+
+    std::vector<std::string> loading; // config files being applied
+}; // struct TranscribeOptions
+
+#endif  // ifndef TRANSCRIBE_OPTIONS_HPP
@@ -0,0 +1,154 @@
+#ifndef TRANSCRIPT_ASSEMBLER_HPP
+#define TRANSCRIPT_ASSEMBLER_HPP
+// EXTERNAL DEPENDENCIES
+// =============================================================================
+#include <cstddef>     // std::size_t
+#include <functional>  // std::function
+#include <string>      // std::string
+#include <string_view> // std::string_view
+#include <utility>     // std::move
+
+
+
+// EXTERNAL API
+// =============================================================================
+
+// one change to the transcript
+struct TranscriptDelta
+{
+    enum class Kind
+    {
+        interim, // the tentative tail changed
+        final    // text was committed, the tentative tail starts over
+    };
+
+    Kind kind;
+
+    // interim: characters of the previous tentative tail still valid
+    // final:   always 0
+    std::size_t retained;
+
+    // interim: replaces the previous tail after 'retained' characters
+    // final:   the committed text
+    // (valid only during the callback)
+    std::string_view text;
+
+    float stability; // of the least stable result contributing
+}; // struct TranscriptDelta
+
+// Assembles StreamingRecognize responses into a committed transcript plus a
+// tentative tail, and tells the subscriber only what changed.  Responses are
+// read in place (results and alternatives by reference); the tail is built
+// in a reused buffer, so steady state does not allocate.
+//
+// Within a response, final results come first and the interim results that
+// follow are ordered from most to least stable, so the tail is the
+// concatenation of the interim results' top alternatives.  Those below
+// 'min_stability' are held back until they firm up.
+class TranscriptAssembler
+{
+public:
+    typedef std::function<void(const TranscriptDelta &)> Subscriber;
+
+    explicit TranscriptAssembler(Subscriber subscriber,
+                                 const float min_stability = 0.0f)
+        : subscriber(std::move(subscriber)),
+          min_stability(min_stability)
+    {}
+
+    // StreamingRecognizeResponse, or anything shaped like it
+    template<typename Response>
+    void
+    consume(const Response &response)
+    {
+        next_tail.clear();
+        float tail_stability = 1.0f;
+
+        for (int r = 0; r < response.results_size(); ++r) {
+            const auto &result = response.results(r);
+
+            if (result.alternatives_size() == 0)
+                continue;
+
+            const std::string &transcript = result.alternatives(0).transcript();
+
+            if (result.is_final()) {
+                commit(transcript);
+                continue;
+            }
+
+            if (result.stability() < min_stability)
+                break; // less stable results follow
+
+            next_tail.append(transcript);
+            tail_stability = (result.stability() < tail_stability)
+                           ? result.stability()
+                           : tail_stability;
+        }
+
+        update_tail(tail_stability);
+    }
+
+    // everything committed so far
+    const std::string &
+    committed() const
+    {
+        return committed_text;
+    }
+
+    // the current tentative tail
+    const std::string &
+    tail() const
+    {
+        return current_tail;
+    }
+
+
+private:
+    void
+    commit(const std::string &transcript)
+    {
+        committed_text.append(transcript);
+
+        // the final result supersedes the tail it grew from
+        current_tail.clear();
+
+        subscriber(TranscriptDelta{ TranscriptDelta::Kind::final,
+                                    0,
+                                    transcript,
+                                    1.0f });
+    }
+
+    void
+    update_tail(const float stability)
+    {
+        if (next_tail == current_tail)
+            return;
+
+        // longest common prefix
+        std::size_t retained = 0;
+        const std::size_t limit = (next_tail.size() < current_tail.size())
+                                ? next_tail.size()
+                                : current_tail.size();
+        while ((retained < limit)
+               && (next_tail[retained] == current_tail[retained]))
+            ++retained;
+
+        current_tail.swap(next_tail);
+
+        subscriber(TranscriptDelta{
+            TranscriptDelta::Kind::interim,
+            retained,
+            std::string_view(current_tail).substr(retained),
+            stability
+        });
+    }
+
+    const Subscriber subscriber;
+    const float min_stability;
+    std::string committed_text;
+    std::string current_tail;
+    std::string next_tail; // reused between responses
+}; // class TranscriptAssembler
+
+#endif  // ifndef TRANSCRIPT_ASSEMBLER_HPP